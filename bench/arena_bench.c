@@ -0,0 +1,139 @@
+#include "bench.h"
+
+/*
+ * Arena benchmarks
+ * Allocation/free throughput of the size-class bins against the plain best-fit tree path.
+ * The size column is the largest request x the number of live blocks, Mcells/s counts
+ * million alloc/free pairs per second
+ */
+
+// -----------------------------------------------------------------------------
+//  Case Definitions
+// -----------------------------------------------------------------------------
+#define ARENA_BENCH_PAIRS 2000000 // Alloc/free pairs per case
+#define ARENA_BENCH_LIVE  1024    // Blocks kept alive while churning
+
+typedef struct ArenaBenchSizes {
+    const char *name;
+    size_t min;     // Smallest request
+    size_t max;     // Largest request
+} ArenaBenchSizes;
+
+static const ArenaBenchSizes size_ranges[] = {
+    {"churn/node",  32,   32},   // List nodes (SignalListenerList, MapObjectList, ...)
+    {"churn/small", 16,   256},  // Everything fits a bin
+    {"churn/mixed", 16,   4096}  // Mostly large requests, bins only help a few
+};
+
+static const struct {
+    bool use_bins;
+    const char *name;
+} paths[] = {
+    {false, "tree"},
+    {true,  "bins"}
+};
+
+
+// -----------------------------------------------------------------------------
+//  Benchmarks
+// -----------------------------------------------------------------------------
+/*
+ * xorshift32, deterministic request sizes and slots
+ */
+static inline uint32_t next_random(uint32_t *seed) {
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+/*
+ * Churn benchmark
+ * Keeps ARENA_BENCH_LIVE blocks alive and replaces a random one per pair
+ */
+static void bench_churn(const ArenaBenchSizes *range, size_t path) {
+    Arena *arena = arena_new_dynamic(BENCH_ARENA_SIZE);
+    arena->use_bins = paths[path].use_bins;
+
+    void **live = (void **)malloc(ARENA_BENCH_LIVE * sizeof(void *));
+    uint32_t seed = 0x2545F491u;
+    size_t span = range->max - range->min + 1;
+    for (int i = 0; i < ARENA_BENCH_LIVE; i++) {
+        live[i] = arena_alloc(arena, range->min + next_random(&seed) % span);
+    }
+
+    long long start = bench_now_ns();
+    for (long i = 0; i < ARENA_BENCH_PAIRS; i++) {
+        uint32_t slot = next_random(&seed) % ARENA_BENCH_LIVE;
+        arena_free_block(live[slot]);
+        live[slot] = arena_alloc(arena, range->min + next_random(&seed) % span);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    BenchResult result = {
+        .suite = "arena",
+        .name = range->name,
+        .variant = paths[path].name,
+        .width = (int)range->max,
+        .height = ARENA_BENCH_LIVE,
+        .iterations = ARENA_BENCH_PAIRS,
+        .elapsed_ns = elapsed,
+        .bytes = 0,
+        .cells = ARENA_BENCH_PAIRS
+    };
+    bench_report(&result);
+
+    free(live);
+    arena_free(arena);
+}
+
+/*
+ * Build and teardown benchmark
+ * Allocates ARENA_BENCH_LIVE nodes and frees them all, like a list that is rebuilt every frame
+ */
+static void bench_rebuild(size_t path) {
+    Arena *arena = arena_new_dynamic(BENCH_ARENA_SIZE);
+    arena->use_bins = paths[path].use_bins;
+
+    void **live = (void **)malloc(ARENA_BENCH_LIVE * sizeof(void *));
+    long rounds = ARENA_BENCH_PAIRS / ARENA_BENCH_LIVE;
+
+    long long start = bench_now_ns();
+    for (long round = 0; round < rounds; round++) {
+        for (int i = 0; i < ARENA_BENCH_LIVE; i++) live[i] = arena_alloc(arena, 32);
+        for (int i = 0; i < ARENA_BENCH_LIVE; i += 2) arena_free_block(live[i]);     // Leaves holes
+        for (int i = 1; i < ARENA_BENCH_LIVE; i += 2) arena_free_block(live[i]);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    BenchResult result = {
+        .suite = "arena",
+        .name = "rebuild/node",
+        .variant = paths[path].name,
+        .width = 32,
+        .height = ARENA_BENCH_LIVE,
+        .iterations = rounds * ARENA_BENCH_LIVE,
+        .elapsed_ns = elapsed,
+        .bytes = 0,
+        .cells = rounds * ARENA_BENCH_LIVE
+    };
+    bench_report(&result);
+
+    free(live);
+    arena_free(arena);
+}
+
+/*
+ * Arena suite
+ */
+void bench_arena(void) {
+    size_t range_count = sizeof(size_ranges) / sizeof(size_ranges[0]);
+    size_t path_count = sizeof(paths) / sizeof(paths[0]);
+
+    for (size_t r = 0; r < range_count; r++) {
+        for (size_t p = 0; p < path_count; p++) bench_churn(&size_ranges[r], p);
+    }
+    for (size_t p = 0; p < path_count; p++) bench_rebuild(p);
+}
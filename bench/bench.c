@@ -0,0 +1,63 @@
+#include "bench.h"
+
+/*
+ * Benchmark runner
+ * Runs every suite and prints one line per case: time per call, bytes per call and cell throughput
+ */
+
+// -----------------------------------------------------------------------------
+//  Timing and Reporting
+// -----------------------------------------------------------------------------
+/*
+ * Monotonic time in nanoseconds
+ */
+long long bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + (long long)now.tv_nsec;
+}
+
+/*
+ * Frame count of a case
+ * Keeps the number of processed cells roughly equal across screen sizes
+ */
+long bench_frames(int width, int height) {
+    long frames = BENCH_CELL_BUDGET / ((long)width * (long)height);
+    if (frames < BENCH_MIN_FRAMES) frames = BENCH_MIN_FRAMES;
+    if (frames > BENCH_MAX_FRAMES) frames = BENCH_MAX_FRAMES;
+    return frames;
+}
+
+/*
+ * Prints the column header of the report
+ */
+void bench_report_header(void) {
+    printf("%-8s %-16s %-10s %9s %12s %12s %10s\n",
+           "suite", "case", "variant", "size", "ns/call", "bytes/call", "Mcells/s");
+}
+
+/*
+ * Prints a single result line
+ */
+void bench_report(const BenchResult *result) {
+    if (result->iterations <= 0 || result->elapsed_ns <= 0) return;
+
+    char size[24];
+    snprintf(size, sizeof(size), "%dx%d", result->width, result->height);
+
+    double ns_per_call = (double)result->elapsed_ns / (double)result->iterations;
+    double bytes_per_call = (double)result->bytes / (double)result->iterations;
+    double mcells_per_s = (double)result->cells * 1000.0 / (double)result->elapsed_ns;
+
+    printf("%-8s %-16s %-10s %9s %12.0f %12.0f %10.2f\n",
+           result->suite, result->name, result->variant, size, ns_per_call, bytes_per_call, mcells_per_s);
+    fflush(stdout);
+}
+
+
+int main(void) {
+    bench_report_header();
+    bench_screen();
+    bench_arena();
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "zen.h"
+
+/*
+ * Benchmark harness
+ * Shared timing and reporting helpers for the 'make bench' suites
+ */
+
+// -----------------------------------------------------------------------------
+//  Constants and Macros
+// -----------------------------------------------------------------------------
+#define BENCH_ARENA_SIZE  (64 * 1024 * 1024) // Arena of every benchmark case
+#define BENCH_CELL_BUDGET 10000000           // Cells processed per case, frame count is derived from it
+#define BENCH_MIN_FRAMES  20
+#define BENCH_MAX_FRAMES  2000
+
+
+// -----------------------------------------------------------------------------
+//  Type Definitions
+// -----------------------------------------------------------------------------
+/*
+ * Result of a single benchmark case
+ * Times are accumulated over 'iterations' calls of the measured function only
+ */
+typedef struct BenchResult {
+    const char *suite;      // Suite name (screen, draw, ...)
+    const char *name;       // Case name
+    const char *variant;    // Mode or configuration of the case
+    int width;              // Screen width
+    int height;             // Screen height
+    long iterations;        // Measured calls
+    long long elapsed_ns;   // Total time spent in the measured calls
+    size_t bytes;           // Bytes produced by the measured calls (0 if not applicable)
+    long long cells;        // Cells processed by the measured calls
+} BenchResult;
+
+
+// -----------------------------------------------------------------------------
+//  Harness functions
+// -----------------------------------------------------------------------------
+long long bench_now_ns(void);
+long      bench_frames(int width, int height);
+void      bench_report_header(void);
+void      bench_report(const BenchResult *result);
+
+// Suites
+void bench_screen(void);
+void bench_arena(void);
+
+#endif // BENCH_H
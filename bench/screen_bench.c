@@ -0,0 +1,294 @@
+#include "bench.h"
+
+/*
+ * Screen benchmarks
+ * print_screen on a headless screen for every TerminalMode, size and content kind,
+ * plus the fill_area / insert_text drawing primitives
+ */
+
+// -----------------------------------------------------------------------------
+//  Case Definitions
+// -----------------------------------------------------------------------------
+typedef struct BenchSize {
+    int width;
+    int height;
+} BenchSize;
+
+typedef void (*BenchContent)(Screen *screen, long frame, uint32_t *seed);
+
+static const BenchSize sizes[] = {
+    {80,  24},  // Classic terminal
+    {200, 60},  // Full-screen window
+    {400, 120}  // Small font on a large display
+};
+
+static const struct {
+    TerminalMode mode;
+    const char  *name;
+} modes[] = {
+    {Color_Base, "base"},
+    {Color_256,  "256"},
+    {Color_RGB,  "rgb"}
+};
+
+static const struct {
+    ScreenLayout layout;
+    const char  *name;
+} layouts[] = {
+    {Layout_Interleaved, "aos"},
+    {Layout_Planar,      "soa"},
+    {Layout_Packed,      "pck"}
+};
+
+static const struct {
+    SimdLevel   level;
+    const char *diff_name;
+    const char *fill_name;
+} simd_levels[] = {
+    {Simd_Scalar, "diff/scalar", "fill/scalar"},
+    {Simd_SSE2,   "diff/sse2",   "fill/sse2"},
+    {Simd_AVX2,   "diff/avx2",   "fill/avx2"}
+};
+
+
+// -----------------------------------------------------------------------------
+//  Frame Content
+// -----------------------------------------------------------------------------
+/*
+ * xorshift32, deterministic noise independent of libc rand()
+ */
+static inline uint32_t next_random(uint32_t *seed) {
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+/*
+ * Static content
+ * The whole screen is redrawn with the same picture, so every span is dirty but nothing changes
+ */
+static void content_static(Screen *screen, long frame, uint32_t *seed) {
+    (void)frame;
+    (void)seed;
+    fill_area(screen, 0, 0, screen->height, screen->width, ' ', COLOR_NAVY, COLOR_WHITE);
+    add_borders(screen, 0, 0, screen->height, screen->width, COLOR_NAVY, COLOR_WHITE, L"─│┌┐└┘├┤");
+    for (int y = 2; y < screen->height - 2; y += 2) {
+        insert_text(screen, y, 2, "The quick brown fox jumps over the lazy dog", COLOR_YELLOW, COLOR_NONE, Effect_Bold);
+    }
+}
+
+/*
+ * Random noise
+ * Every cell gets a random glyph and random truecolor pair, worst case for the encoder
+ */
+static void content_noise(Screen *screen, long frame, uint32_t *seed) {
+    (void)frame;
+    for (int y = 0; y < screen->height; y++) {
+        for (int x = 0; x < screen->width; x++) {
+            uint32_t value = next_random(seed);
+            Color background = (Color){value & 0x00FFFFFF};
+            Color foreground = (Color){next_random(seed) & 0x00FFFFFF};
+            put_pixel(screen, y, x, (wchar_t)('!' + (value >> 24) % 94), background, foreground, Effect_None);
+        }
+    }
+}
+
+/*
+ * Donut-like gradient
+ * Smooth moving shading drawn as 1x2 background blocks, like the 3d_donut example
+ */
+static void content_gradient(Screen *screen, long frame, uint32_t *seed) {
+    (void)seed;
+    float t = (float)frame * 0.15f;
+    for (int y = 0; y < screen->height; y++) {
+        for (int x = 0; x + 1 < screen->width; x += 2) {
+            float shade = sinf((float)x * 0.05f + t) * cosf((float)y * 0.11f - t * 0.5f);
+            int brightness = (int)(127.5f + 127.5f * shade);
+            Color gray = (Color){(uint32_t)(brightness << 16) | (uint32_t)(brightness << 8) | (uint32_t)brightness};
+            fill_area(screen, y, x, 1, 2, ' ', gray, COLOR_NONE);
+        }
+    }
+}
+
+static const struct {
+    BenchContent draw;
+    const char  *name;
+} contents[] = {
+    {content_static,   "print/static"},
+    {content_noise,    "print/noise"},
+    {content_gradient, "print/gradient"}
+};
+
+
+// -----------------------------------------------------------------------------
+//  Benchmarks
+// -----------------------------------------------------------------------------
+/*
+ * print_screen benchmark
+ * Draws the content outside of the timed region, measures only the encoder and diff.
+ * More than one thread encodes in row bands
+ */
+static void bench_print(const BenchSize *size, size_t layout, size_t mode, int threads, BenchContent draw, const char *name) {
+    Arena *arena = arena_new_dynamic(BENCH_ARENA_SIZE);
+    Screen *screen = init_screen_headless(arena, size->width, size->height, COLOR_BLACK, COLOR_WHITE, ' ', NULL, NULL);
+    screen_set_layout(screen, layouts[layout].layout);
+    screen_set_encode_threads(screen, threads);
+    screen->mode = modes[mode].mode;
+
+    char variant[16];
+    if (threads > 1) snprintf(variant, sizeof(variant), "%s/%s/%dt", modes[mode].name, layouts[layout].name, threads);
+    else             snprintf(variant, sizeof(variant), "%s/%s", modes[mode].name, layouts[layout].name);
+
+    uint32_t seed = 0x2545F491u;
+    long frames = bench_frames(size->width, size->height);
+
+    // Warm-up frame, pays the initial full redraw and fills the attribute cache
+    draw(screen, 0, &seed);
+    print_screen(screen);
+    screen_reset_stats(screen);
+
+    long long elapsed = 0;
+    for (long frame = 1; frame <= frames; frame++) {
+        draw(screen, frame, &seed);
+
+        long long start = bench_now_ns();
+        print_screen(screen);
+        elapsed += bench_now_ns() - start;
+    }
+
+    BenchResult result = {
+        .suite = "screen",
+        .name = name,
+        .variant = variant,
+        .width = size->width,
+        .height = size->height,
+        .iterations = frames,
+        .elapsed_ns = elapsed,
+        .bytes = screen->stats.total_bytes,
+        .cells = (long long)frames * size->width * size->height
+    };
+    bench_report(&result);
+
+    screen_shutdown(screen);
+    arena_free(arena);
+}
+
+/*
+ * fill_area benchmark
+ * Full-screen fills alternating two colors
+ */
+static void bench_fill_area(const BenchSize *size, size_t layout, const char *name) {
+    Arena *arena = arena_new_dynamic(BENCH_ARENA_SIZE);
+    Screen *screen = init_screen_headless(arena, size->width, size->height, COLOR_BLACK, COLOR_WHITE, ' ', NULL, NULL);
+    screen_set_layout(screen, layouts[layout].layout);
+    long iterations = bench_frames(size->width, size->height);
+
+    long long start = bench_now_ns();
+    for (long i = 0; i < iterations; i++) {
+        Color background = (i & 1) ? COLOR_NAVY : COLOR_MAROON;
+        fill_area(screen, 0, 0, screen->height, screen->width, '#', background, COLOR_WHITE);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    BenchResult result = {
+        .suite = "draw",
+        .name = name,
+        .variant = layouts[layout].name,
+        .width = size->width,
+        .height = size->height,
+        .iterations = iterations,
+        .elapsed_ns = elapsed,
+        .bytes = 0,
+        .cells = (long long)iterations * size->width * size->height
+    };
+    bench_report(&result);
+
+    screen_shutdown(screen);
+    arena_free(arena);
+}
+
+/*
+ * insert_text benchmark
+ * Fills every row with a line of text, one call per row
+ */
+static void bench_insert_text(const BenchSize *size, size_t layout) {
+    Arena *arena = arena_new_dynamic(BENCH_ARENA_SIZE);
+    Screen *screen = init_screen_headless(arena, size->width, size->height, COLOR_BLACK, COLOR_WHITE, ' ', NULL, NULL);
+    screen_set_layout(screen, layouts[layout].layout);
+    long iterations = bench_frames(size->width, size->height);
+
+    char *line = (char *)arena_alloc(arena, (size_t)size->width + 1);
+    for (int x = 0; x < size->width; x++) line[x] = (char)('a' + x % 26);
+    line[size->width] = '\0';
+
+    long long start = bench_now_ns();
+    for (long i = 0; i < iterations; i++) {
+        for (int y = 0; y < size->height; y++) {
+            insert_text(screen, y, 0, line, COLOR_YELLOW, COLOR_NONE, (i & 1) ? Effect_Bold : Effect_None);
+        }
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    BenchResult result = {
+        .suite = "draw",
+        .name = "insert_text",
+        .variant = layouts[layout].name,
+        .width = size->width,
+        .height = size->height,
+        .iterations = iterations,
+        .elapsed_ns = elapsed,
+        .bytes = 0,
+        .cells = (long long)iterations * size->width * size->height
+    };
+    bench_report(&result);
+
+    arena_free_block(line);
+    screen_shutdown(screen);
+    arena_free(arena);
+}
+
+/*
+ * Screen suite
+ */
+void bench_screen(void) {
+    size_t size_count = sizeof(sizes) / sizeof(sizes[0]);
+    size_t mode_count = sizeof(modes) / sizeof(modes[0]);
+    size_t layout_count = sizeof(layouts) / sizeof(layouts[0]);
+    size_t content_count = sizeof(contents) / sizeof(contents[0]);
+
+    for (size_t c = 0; c < content_count; c++) {
+        for (size_t l = 0; l < layout_count; l++) {
+            for (size_t m = 0; m < mode_count; m++) {
+                for (size_t s = 0; s < size_count; s++) {
+                    bench_print(&sizes[s], l, m, 1, contents[c].draw, contents[c].name);
+                }
+            }
+        }
+    }
+
+    // Row-band encoding of the largest size, worst case (noise) and typical (gradient) content
+    static const int thread_counts[] = {2, 4};
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        bench_print(&sizes[2], 0, 2, thread_counts[t], content_noise, "print/noise");
+        bench_print(&sizes[2], 0, 2, thread_counts[t], content_gradient, "print/gradient");
+    }
+
+    for (size_t l = 0; l < layout_count; l++) {
+        for (size_t s = 0; s < size_count; s++) bench_fill_area(&sizes[s], l, "fill_area");
+        for (size_t s = 0; s < size_count; s++) bench_insert_text(&sizes[s], l);
+    }
+
+    // Frame diff and fill kernels per instruction set level (static content is pure diffing)
+    size_t level_count = sizeof(simd_levels) / sizeof(simd_levels[0]);
+    for (size_t i = 0; i < level_count; i++) {
+        if (screen_set_simd(simd_levels[i].level) != simd_levels[i].level) continue; // Not supported by the CPU
+        for (size_t l = 0; l < layout_count; l++) {
+            bench_print(&sizes[2], l, 2, 1, content_static, simd_levels[i].diff_name);
+            bench_fill_area(&sizes[2], l, simd_levels[i].fill_name);
+        }
+    }
+    screen_set_simd(Simd_Auto);
+}
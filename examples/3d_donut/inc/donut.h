@@ -3,8 +3,11 @@
 
 #include "zen.h"
 
-#define DONUT_HEIGHT 30
-#define DONUT_WIDTH  30
+#define DONUT_HEIGHT 30 // Cells
+#define DONUT_WIDTH  30 // Cells, every cell is drawn two columns wide
+
+#define DONUT_DOTS_Y (DONUT_HEIGHT * 2) // Half-block canvas resolution
+#define DONUT_DOTS_X (DONUT_WIDTH  * 2)
 
 #define BORDER_OFFSET_X 1
 #define BORDER_OFFSET_Y 1
@@ -20,6 +23,8 @@ typedef struct Donut {
     ObjectInterfaces interfaces;
     float A;
     float B;
+    Canvas *canvas;  // Half-block canvas inside the border
+    float *z_buffer; // Inverse depth per canvas dot
 } Donut;
 
 
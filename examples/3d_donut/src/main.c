@@ -18,8 +18,8 @@ static void print_donut(const void *donut_pointer, Screen *screen, const Cursor
     A = donut->A;
     B = donut->B;
 
-    int bufferSize = DONUT_WIDTH * DONUT_HEIGHT;
-    float z_buffer[bufferSize];
+    int bufferSize = DONUT_DOTS_X * DONUT_DOTS_Y;
+    float *z_buffer = donut->z_buffer;
     float theta, phi;
 
     float sinA = sinf(A);
@@ -27,7 +27,7 @@ static void print_donut(const void *donut_pointer, Screen *screen, const Cursor
     float sinB = sinf(B);
     float cosB = cosf(B);
 
-    fill_area(screen, BORDER_OFFSET_Y, BORDER_OFFSET_X, SCREEN_HEIGHT - BORDER_OFFSET_Y * 2, SCREEN_WIDTH - BORDER_OFFSET_X * 2, ' ', COLOR_BLACK, COLOR_RED);
+    canvas_clear(donut->canvas);
     memset(z_buffer, 0, (size_t)bufferSize * sizeof(float)); // Fill with 0
 
     // --- ADJUSTED SAMPLING RATES ---
@@ -60,14 +60,14 @@ static void print_donut(const void *donut_pointer, Screen *screen, const Cursor
             float scaledY = D * (l_h * sinB + t * cosB);
 
             // 2. Scale by donutWidth/Height and THEN center.
-            int x = (int)((DONUT_WIDTH  / 2.0f) * scaledX + (DONUT_WIDTH  / 2.0f));
-            int y = (int)((DONUT_HEIGHT / 2.0f) * scaledY + (DONUT_HEIGHT / 2.0f));
+            int x = (int)((DONUT_DOTS_X / 2.0f) * scaledX + (DONUT_DOTS_X / 2.0f));
+            int y = (int)((DONUT_DOTS_Y / 2.0f) * scaledY + (DONUT_DOTS_Y / 2.0f));
 
-            int o = x + DONUT_WIDTH * y;
+            int o = x + DONUT_DOTS_X * y;
             float N = ((f_e - c_d * cosA) * cosB - c_d * sinA - f_g - cosPhi * h_g);
 
             // --- BOUNDS CHECKING ---
-            if (y >= 0 && y < DONUT_HEIGHT && x >= 0 && x < DONUT_WIDTH && D > z_buffer[o]) {
+            if (y >= 0 && y < DONUT_DOTS_Y && x >= 0 && x < DONUT_DOTS_X && D > z_buffer[o]) {
                 z_buffer[o] = D;
                 
                 float normalizedN = N > 0 ? N : 0;
@@ -77,10 +77,13 @@ static void print_donut(const void *donut_pointer, Screen *screen, const Cursor
                 int brightness = (int)brightnessF; // Convert back to integer
                 Color grayColor = (Color){0x00000000 | (uint32_t)(brightness << 16) | (uint32_t)(brightness << 8) | (uint32_t)(brightness << 0)};
 
-                fill_area(screen, BORDER_OFFSET_Y + y, BORDER_OFFSET_X + x*2, 1, 2, ' ', grayColor, COLOR_NONE);
+                canvas_plot(donut->canvas, y, x, grayColor);
             }
         }
     }
+
+    // One pass from dots to half-block cells
+    canvas_draw(donut->canvas, screen);
 }
 
 
@@ -112,6 +115,9 @@ static Donut *init_donut(Arena *arena) {
 
     donut->A = 0;
     donut->B = 0;
+    donut->canvas = canvas_init(arena, Canvas_HalfBlock, BORDER_OFFSET_Y, BORDER_OFFSET_X * 2,
+                                DONUT_HEIGHT, DONUT_DOTS_X, COLOR_BLACK);
+    donut->z_buffer = (float *)arena_alloc(arena, DONUT_DOTS_X * DONUT_DOTS_Y * sizeof(float));
 
     INTERFACES(arena, donut, {
         DRAWABLE(print_donut);
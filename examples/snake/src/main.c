@@ -56,8 +56,8 @@ static void game_loop(Zen *zen) {
 int main(void) {
     srand((unsigned int)time(NULL));
 
-    ssize_t size = 1024 * 80;  // 73928kb is minimum
-    Arena *arena = arena_new_dynamic(size);
+    ssize_t size = 1024 * 32;  // Grows by chaining regions when the screen needs more
+    Arena *arena = arena_new_growable(size, 0);
 
     Zen *zen = zen_init(arena);
     
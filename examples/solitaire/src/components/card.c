@@ -55,8 +55,8 @@ void print_card(Screen *screen, const Card *card, int y, int x, int size_y, int
         fill_area(screen, y_0, x_0, size_y, size_x, L'░', ((Color){0x006e651a}), ((Color){0x006e651a}));
         add_borders(screen, y_0, x_0, size_y, size_x, ((Color){0x00383307}), COLOR_WHITE, slim_border);
         if (y != CARD_HEIGHT + 2 * BORDER_OFFSET_Y + 1 && y != BORDER_OFFSET_Y) {
-            screen->pixels[y_0][x_0].symbol = slim_border[6];
-            screen->pixels[y_0][x_0 + CARD_WIDTH - 1].symbol = slim_border[7];
+            screen_set_symbol(screen, y_0, x_0, slim_border[6]);
+            screen_set_symbol(screen, y_0, x_0 + CARD_WIDTH - 1, slim_border[7]);
         }
         return;
     }
@@ -66,29 +66,29 @@ void print_card(Screen *screen, const Card *card, int y, int x, int size_y, int
     add_borders(screen, y_0, x_0, size_y, size_x, ((Color){0x00383307}), COLOR_WHITE, slim_border);
 
     if (y != CARD_HEIGHT + 2 * BORDER_OFFSET_Y + 1 && y != BORDER_OFFSET_Y) {
-        screen->pixels[y_0][x_0].symbol = slim_border[6];
-        screen->pixels[y_0][x_0 + CARD_WIDTH - 1].symbol = slim_border[7];
+        screen_set_symbol(screen, y_0, x_0, slim_border[6]);
+        screen_set_symbol(screen, y_0, x_0 + CARD_WIDTH - 1, slim_border[7]);
     }
 
     if (card->selected) {
-        screen->pixels[y_0][x_0 + 3].symbol = L'◖';
-        screen->pixels[y_0][x_0 + 4].symbol = L'◗';
+        screen_set_symbol(screen, y_0, x_0 + 3, L'◖');
+        screen_set_symbol(screen, y_0, x_0 + 4, L'◗');
     }
 
     wchar_t suit = suit_to_text(card->suit);
-    screen->pixels[y_0 + 1][x_0 + 1].symbol = suit;
-    screen->pixels[y_0 + CARD_HEIGHT / 2][x_0 + CARD_WIDTH / 2 - 1].symbol = suit;
-    screen->pixels[y_0 + CARD_HEIGHT - 2][x_0 + CARD_WIDTH - 3].symbol = suit;
+    screen_set_symbol(screen, y_0 + 1, x_0 + 1, suit);
+    screen_set_symbol(screen, y_0 + CARD_HEIGHT / 2, x_0 + CARD_WIDTH / 2 - 1, suit);
+    screen_set_symbol(screen, y_0 + CARD_HEIGHT - 2, x_0 + CARD_WIDTH - 3, suit);
 
     const char *numeral = numeral_to_text(card->numeral);
-    screen->pixels[y_0 + 1][x_0 + CARD_WIDTH - 3].symbol = numeral[0];
-    screen->pixels[y_0 + 1][x_0 + CARD_WIDTH - 2].symbol = numeral[1];
+    screen_set_symbol(screen, y_0 + 1, x_0 + CARD_WIDTH - 3, numeral[0]);
+    screen_set_symbol(screen, y_0 + 1, x_0 + CARD_WIDTH - 2, numeral[1]);
     if (numeral[0] == ' ') {
-        screen->pixels[y_0 + CARD_HEIGHT - 2][x_0 + 1].symbol = numeral[1];
+        screen_set_symbol(screen, y_0 + CARD_HEIGHT - 2, x_0 + 1, numeral[1]);
     }
     else {
-        screen->pixels[y_0 + CARD_HEIGHT - 2][x_0 + 1].symbol = numeral[0];
-        screen->pixels[y_0 + CARD_HEIGHT - 2][x_0 + 2].symbol = numeral[1];
+        screen_set_symbol(screen, y_0 + CARD_HEIGHT - 2, x_0 + 1, numeral[0]);
+        screen_set_symbol(screen, y_0 + CARD_HEIGHT - 2, x_0 + 2, numeral[1]);
     }
 }
 
@@ -105,17 +105,17 @@ void colorize_card(Screen *screen, const Card *card, int y, int x, int height, i
     for (int i = y; i < y + height; i++) {
         for (int j = x; j < x + width; j++) {
             if (i < SCREEN_HEIGHT && j < SCREEN_WIDTH) {
-                screen->pixels[i][j] = pixel;
+                screen_set_pixel(screen, i, j, pixel);
             }
         }
     }
 
-    screen->pixels[y][x].foreground = (card->suit % 2 != 0) ? COLOR_RED : COLOR_BLACK;
-    screen->pixels[y + CARD_HEIGHT / 2 - 1][x + CARD_WIDTH / 2 - 1 - 1].foreground  = (card->suit % 2 != 0) ? COLOR_RED : COLOR_BLACK;
-    screen->pixels[y + CARD_HEIGHT - 2 - 1][x + CARD_WIDTH - 3 - 1].foreground  = (card->suit % 2 != 0) ? COLOR_RED : COLOR_BLACK;
+    screen_set_foreground(screen, y, x, (card->suit % 2 != 0) ? COLOR_RED : COLOR_BLACK);
+    screen_set_foreground(screen, y + CARD_HEIGHT / 2 - 1, x + CARD_WIDTH / 2 - 1 - 1, (card->suit % 2 != 0) ? COLOR_RED : COLOR_BLACK);
+    screen_set_foreground(screen, y + CARD_HEIGHT - 2 - 1, x + CARD_WIDTH - 3 - 1, (card->suit % 2 != 0) ? COLOR_RED : COLOR_BLACK);
 
-    screen->pixels[y][x + width - 2].foreground = COLOR_BLACK;
-    screen->pixels[y][x + width - 1].foreground = COLOR_BLACK;
-    screen->pixels[y + height - 1][x].foreground = COLOR_BLACK;
-    if (card->numeral % 10 == 0) screen->pixels[y + height - 1][x + 1].foreground = COLOR_BLACK;
+    screen_set_foreground(screen, y, x + width - 2, COLOR_BLACK);
+    screen_set_foreground(screen, y, x + width - 1, COLOR_BLACK);
+    screen_set_foreground(screen, y + height - 1, x, COLOR_BLACK);
+    if (card->numeral % 10 == 0) screen_set_foreground(screen, y + height - 1, x + 1, COLOR_BLACK);
 }
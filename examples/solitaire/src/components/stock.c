@@ -120,8 +120,8 @@ static void print_stock(const void *stock_pointer, Screen *screen, const Cursor
         }
         else {
             add_borders(screen, BORDER_OFFSET_Y, x, CARD_HEIGHT, CARD_WIDTH, ((Color){0x0030992e}), COLOR_WHITE, fat_border);
-            screen->pixels[BORDER_OFFSET_Y + CARD_HEIGHT / 2][x + CARD_WIDTH / 2 - 1].symbol = suit_to_text((Suit)suit);
-            screen->pixels[BORDER_OFFSET_Y + CARD_HEIGHT / 2][x + CARD_WIDTH / 2 - 1].foreground = (suit % 2 != 0) ? COLOR_RED : COLOR_BLACK;
+            screen_set_symbol(screen, BORDER_OFFSET_Y + CARD_HEIGHT / 2, x + CARD_WIDTH / 2 - 1, suit_to_text((Suit)suit));
+            screen_set_foreground(screen, BORDER_OFFSET_Y + CARD_HEIGHT / 2, x + CARD_WIDTH / 2 - 1, (suit % 2 != 0) ? COLOR_RED : COLOR_BLACK);
         }
     }
 }
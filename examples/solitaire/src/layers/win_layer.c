@@ -39,6 +39,7 @@ MapLayer *win_layer_init(Arena *arena, Game *game) {
         prepare_screen = prepare_win_screen;
         cursor_loop = win_cursor_loop;
         main_object = win_screen;
+        base = GAME_ID; // Drawn over the frozen game board
     }, {
         OBJECT(win_screen, COORDS(0, 0));
     });
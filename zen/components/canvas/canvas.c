@@ -0,0 +1,248 @@
+#ifndef CUSTOM_CANVAS
+
+/*
+ * Canvas implementation
+ * Plots dots into a color grid and resolves them to half-block or braille cells
+ */
+#include "../zen.h"
+#include <limits.h>
+
+#define BRAILLE_BASE 0x2800 // Braille pattern without dots
+
+/*
+ * Braille dot bits
+ * Indexed by [dot row][dot column] of a 2x4 cell
+ */
+static const unsigned char braille_bits[4][2] = {
+    {0x01, 0x08},
+    {0x02, 0x10},
+    {0x04, 0x20},
+    {0x40, 0x80},
+};
+
+
+// -----------------------------------------------------------------------------
+//  Canvas Management
+// -----------------------------------------------------------------------------
+/*
+ * Initialize canvas
+ * Covers rows * columns cells starting at drawing position (y, x), all dots unset.
+ * Returns NULL if the dot grid does not fit an int or the arena is out of memory
+ */
+Canvas *canvas_init(Arena *arena, CanvasMode mode, int y, int x, int rows, int columns, Color background) {
+    if (rows <= 0 || columns <= 0) return NULL;
+    int dot_rows = (mode == Canvas_Braille) ? 4 : 2;
+    int dot_columns = (mode == Canvas_Braille) ? 2 : 1;
+    if (rows > INT_MAX / dot_rows || columns > INT_MAX / dot_columns) return NULL;
+    size_t height = (size_t)rows * (size_t)dot_rows;
+    size_t width = (size_t)columns * (size_t)dot_columns;
+    if (height > SIZE_MAX / sizeof(Color) / width) return NULL;
+
+    Canvas *canvas = (Canvas *)arena_alloc(arena, sizeof(Canvas));
+    if (!canvas) return NULL;
+    *canvas = (Canvas) {
+        .mode = mode,
+        .y = y,
+        .x = x,
+        .rows = rows,
+        .columns = columns,
+        .height = (int)height,
+        .width = (int)width,
+        .background = background,
+        .arena = arena
+    };
+
+    canvas->dots = (Color *)arena_alloc(arena, height * width * sizeof(Color));
+    if (!canvas->dots) {
+        arena_free_block(canvas);
+        return NULL;
+    }
+    canvas_clear(canvas);
+    return canvas;
+}
+
+/*
+ * Free canvas
+ */
+void canvas_free(Canvas *canvas) {
+    if (!canvas) return;
+    arena_free_block(canvas->dots);
+    arena_free_block(canvas);
+}
+
+/*
+ * Clear canvas
+ * Unsets every dot
+ */
+void canvas_clear(Canvas *canvas) {
+    if (!canvas || !canvas->dots) return;
+    size_t count = (size_t)canvas->height * (size_t)canvas->width;
+    for (size_t i = 0; i < count; i++) canvas->dots[i] = COLOR_NONE;
+}
+
+
+// -----------------------------------------------------------------------------
+//  Plotting
+// -----------------------------------------------------------------------------
+/*
+ * Plot a dot
+ * Dot coordinates outside the canvas are ignored
+ */
+void canvas_plot(Canvas *canvas, int y, int x, Color color) {
+    if (!canvas || y < 0 || x < 0 || y >= canvas->height || x >= canvas->width) return;
+    canvas->dots[(size_t)y * (size_t)canvas->width + (size_t)x] = color;
+}
+
+/*
+ * Plot many dots
+ * Point i is (ys[i], xs[i]) with colors[i]
+ */
+void canvas_plot_points(Canvas *canvas, const int *ys, const int *xs, const Color *colors, int count) {
+    if (!canvas || !ys || !xs || !colors) return;
+
+    for (int i = 0; i < count; i++) {
+        if (ys[i] < 0 || xs[i] < 0 || ys[i] >= canvas->height || xs[i] >= canvas->width) continue;
+        canvas->dots[(size_t)ys[i] * (size_t)canvas->width + (size_t)xs[i]] = colors[i];
+    }
+}
+
+/*
+ * Draw a line
+ * Bresenham line between two dots, both ends included
+ */
+void canvas_line(Canvas *canvas, int y0, int x0, int y1, int x1, Color color) {
+    if (!canvas) return;
+
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int step_x = (x0 < x1) ? 1 : -1;
+    int step_y = (y0 < y1) ? 1 : -1;
+    int error = dx + dy;
+
+    for (;;) {
+        canvas_plot(canvas, y0, x0, color);
+        if (x0 == x1 && y0 == y1) break;
+
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            x0 += step_x;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            y0 += step_y;
+        }
+    }
+}
+
+/*
+ * Fill a rectangle of dots
+ * The rectangle is clipped to the canvas
+ */
+void canvas_fill(Canvas *canvas, int y, int x, int height, int width, Color color) {
+    if (!canvas) return;
+
+    int top = (y > 0) ? y : 0;
+    int left = (x > 0) ? x : 0;
+    int bottom = (y + height < canvas->height) ? y + height : canvas->height;
+    int right = (x + width < canvas->width) ? x + width : canvas->width;
+
+    for (int row = top; row < bottom; row++) {
+        Color *dots = canvas->dots + (size_t)row * (size_t)canvas->width;
+        for (int column = left; column < right; column++) dots[column] = color;
+    }
+}
+
+/*
+ * Copy a block of dots
+ * Copies height * width colors ('stride' colors per source row) to dot (y, x), COLOR_NONE
+ * source dots leave the canvas unchanged
+ */
+void canvas_blit(Canvas *canvas, int y, int x, int height, int width, const Color *dots, int stride) {
+    if (!canvas || !dots) return;
+
+    int top = (y > 0) ? y : 0;
+    int left = (x > 0) ? x : 0;
+    int bottom = (y + height < canvas->height) ? y + height : canvas->height;
+    int right = (x + width < canvas->width) ? x + width : canvas->width;
+
+    for (int row = top; row < bottom; row++) {
+        const Color *source = dots + (size_t)(row - y) * (size_t)stride + (size_t)(left - x);
+        Color *target = canvas->dots + (size_t)row * (size_t)canvas->width + (size_t)left;
+        for (int i = 0; i < right - left; i++) {
+            if (!is_none(source[i])) target[i] = source[i];
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//  Cell Resolution
+// -----------------------------------------------------------------------------
+/*
+ * Resolve a half-block cell
+ * Upper dot in the foreground of an upper half block, lower dot in its background
+ */
+static Pixel half_block_cell(const Canvas *canvas, Color upper, Color lower) {
+    bool has_upper = !is_none(upper);
+    bool has_lower = !is_none(lower);
+
+    if (has_upper && has_lower) {
+        if (upper.color == lower.color) return (Pixel) {canvas->background, upper, L'█', Effect_None};
+        return (Pixel) {lower, upper, L'▀', Effect_None};
+    }
+    if (has_upper) return (Pixel) {canvas->background, upper, L'▀', Effect_None};
+    if (has_lower) return (Pixel) {canvas->background, lower, L'▄', Effect_None};
+    return (Pixel) {canvas->background, COLOR_NONE, L' ', Effect_None};
+}
+
+/*
+ * Resolve a braille cell
+ * Sets one bit per dot, the foreground is the average color of the set dots
+ */
+static Pixel braille_cell(const Canvas *canvas, int row, int column) {
+    unsigned bits = 0;
+    unsigned red = 0, green = 0, blue = 0, count = 0;
+
+    for (int dy = 0; dy < 4; dy++) {
+        const Color *dots = canvas->dots + (size_t)(row * 4 + dy) * (size_t)canvas->width + (size_t)(column * 2);
+        for (int dx = 0; dx < 2; dx++) {
+            if (is_none(dots[dx])) continue;
+            bits |= braille_bits[dy][dx];
+            red += get_red(dots[dx]);
+            green += get_green(dots[dx]);
+            blue += get_blue(dots[dx]);
+            count++;
+        }
+    }
+
+    if (!count) return (Pixel) {canvas->background, COLOR_NONE, L' ', Effect_None};
+    Color color = {((red / count) << 16) | ((green / count) << 8) | (blue / count)};
+    return (Pixel) {canvas->background, color, (wchar_t)(BRAILLE_BASE + bits), Effect_None};
+}
+
+/*
+ * Draw canvas on screen
+ * Resolves every cell in one pass and writes it with put_pixel, so the active clip rectangle and
+ * viewport apply. Empty cells are skipped when the canvas has no background.
+ */
+void canvas_draw(const Canvas *canvas, Screen *screen) {
+    if (!canvas || !screen) return;
+    bool opaque = !is_none(canvas->background);
+
+    for (int row = 0; row < canvas->rows; row++) {
+        const Color *upper = canvas->dots + (size_t)(row * 2) * (size_t)canvas->width;
+        const Color *lower = upper + canvas->width;
+
+        for (int column = 0; column < canvas->columns; column++) {
+            Pixel cell = (canvas->mode == Canvas_Braille)
+                       ? braille_cell(canvas, row, column)
+                       : half_block_cell(canvas, upper[column], lower[column]);
+            if (!opaque && cell.symbol == L' ') continue;
+
+            put_pixel(screen, canvas->y + row, canvas->x + column, cell.symbol, cell.background, cell.foreground, cell.effect);
+        }
+    }
+}
+
+#endif // CUSTOM_CANVAS
@@ -0,0 +1,57 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include "../components.h"
+
+/*
+ * Canvas - Sub-cell pixel graphics
+ * A grid of dots attached to a screen region, resolved to block or braille glyphs when drawn
+ */
+
+// -----------------------------------------------------------------------------
+//  Type Definitions
+// -----------------------------------------------------------------------------
+/*
+ * Canvas resolutions
+ * Half-block gives every dot its own color, braille has four times the dots but one color per cell
+ */
+typedef enum {
+    Canvas_HalfBlock, // 1x2 dots per cell (upper/lower half block, foreground and background colors)
+    Canvas_Braille    // 2x4 dots per cell (braille patterns, the cell color is the average of its dots)
+} CanvasMode;
+
+/*
+ * Canvas structure
+ * Dots are stored row-major, COLOR_NONE marks an unset dot
+ */
+struct Canvas {
+    CanvasMode mode;   // Dot resolution
+    int y;             // Drawing row of the top-left cell
+    int x;             // Drawing column of the top-left cell
+    int rows;          // Height in cells
+    int columns;       // Width in cells
+    int height;        // Height in dots
+    int width;         // Width in dots
+    Color background;  // Background of cells without dots (COLOR_NONE keeps the screen background)
+    Color *dots;       // height * width dot colors
+    Arena *arena;      // Arena the dots are allocated from
+};
+
+
+/*
+ * Canvas functions
+ * Dot plotting and cell resolution
+ */
+#ifndef CUSTOM_CANVAS
+    Canvas *canvas_init(Arena *arena, CanvasMode mode, int y, int x, int rows, int columns, Color background);
+    void canvas_free(Canvas *canvas);
+    void canvas_clear(Canvas *canvas);
+    void canvas_plot(Canvas *canvas, int y, int x, Color color);
+    void canvas_plot_points(Canvas *canvas, const int *ys, const int *xs, const Color *colors, int count);
+    void canvas_line(Canvas *canvas, int y0, int x0, int y1, int x1, Color color);
+    void canvas_fill(Canvas *canvas, int y, int x, int height, int width, Color color);
+    void canvas_blit(Canvas *canvas, int y, int x, int height, int width, const Color *dots, int stride);
+    void canvas_draw(const Canvas *canvas, Screen *screen);
+#endif
+
+#endif
@@ -16,6 +16,7 @@
 #include "zen_arena/arena_alloc.h"
 #include "container/container.h"
 #include "screen/screen.h"
+#include "canvas/canvas.h"
 #include "cursor/cursor.h"
 #include "map/map.h"
 #include "time_manager/time_manager.h"
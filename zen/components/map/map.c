@@ -31,6 +31,7 @@ MapLayer *create_map_layer(Arena *arena, int height, int width, Coords base_coor
         .height = height,
         .width  = width,
         .default_layer_coords = base_coords,
+        .base_layer = -1,
     };
 
     map_layer->objects = (MapObject **)arena_alloc(arena, (size_t)(map_layer->height) * sizeof(MapObject *));
@@ -65,6 +66,15 @@ inline MapLayer *map_get_current_layer(Map *map) {
     return map->layers[map->global_coords.z];
 }
 
+/*
+ * Get base layer
+ * Returns the layer composited below the given one, NULL if it has none
+ */
+MapLayer *map_get_base_layer(Map *map, const MapLayer *layer) {
+    if (layer->base_layer < 0 || layer->base_layer >= map->layers_count) return NULL;
+    return map->layers[layer->base_layer];
+}
+
 /*
  * Move cursor on map to new position
  * Validates move and checks if target position is interactable
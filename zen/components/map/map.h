@@ -31,6 +31,8 @@ typedef struct MapLayer {
     void (*prepare_screen)(Screen *screen);             // Function to prepare screen for the layer
     void (*layer_loop)(Zen *zen, wint_t key);           // Function to handle layer loop
     bool (*layer_cursor_loop)(Zen *zen, wint_t key);    // Function to handle cursor movement
+    int base_layer;                                     // Layer composited below this one (-1 for none)
+    Screen *static_cells;                               // Cached static output of a composited layer
 } MapLayer;
 
 
@@ -55,6 +57,7 @@ void map_move_layer(Map *map, int layer);
 MapLayer *create_map_layer(Arena *arena, int height, int width, Coords base_coords);
 MapLayer *map_get_layer(Map *map, int layer);
 MapLayer *map_get_current_layer(Map *map);
+MapLayer *map_get_base_layer(Map *map, const MapLayer *layer);
 MapObject map_get_current_object(Map *map);
 MapObject map_get_object(Map *map, Coords coords);
 
@@ -94,8 +97,11 @@ MapObject map_get_object(Map *map, Coords coords);
         void (*loop)(Zen *zen, wint_t key) = NULL;                                                                         \
         bool (*cursor_loop)(Zen *zen, wint_t key) = NULL;                                                                  \
         void *main_object = NULL;                                                                                            \
+        int base = -1;                                                                                                       \
         _params;                                                                                                             \
         _name->prepare_screen = prepare_screen;                                                                              \
+        _name->base_layer = base;                                                                                            \
+        _name->static_cells = NULL;                                                                                          \
         _name->layer_loop = loop;                                                                                            \
         _name->layer_cursor_loop = cursor_loop;                                                                              \
         _name->layer_main_object = main_object;                                                                              \
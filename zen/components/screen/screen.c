@@ -4,6 +4,9 @@
  * Handles terminal output and screen buffer management
  */
 #include "../zen.h"
+#include <pthread.h>
+#include <signal.h>
+#include <sys/ioctl.h>
 
 // -----------------------------------------------------------------------------
 //  ANSI Escape Code Generation
@@ -12,11 +15,10 @@
  * Generates an ANSI escape sequence for text effects.
  * It formats the text effect into the ANSI escape sequence.
  */
-static char* get_effect_ansi(TextEffect effect) {
-    static char ansi_str[16];             // Buffer for the ANSI escape sequence
+static char* get_effect_ansi(char *ansi_str, size_t size, TextEffect effect) {
     if (effect == Effect_None) return ""; // Return empty string if no effect
 
-    snprintf(ansi_str, sizeof(ansi_str), "\033[%dm", (int)effect);
+    snprintf(ansi_str, size, "\033[%dm", (int)effect);
     return ansi_str;
 }
 
@@ -138,327 +140,2070 @@ static TerminalMode get_terminal_mode(void) {
  * Converts RGB color to an ANSI escape sequence for TrueColor terminals.
  * It formats the RGB values into the ANSI escape sequence for TrueColor terminals.
  */
-static char* rgb_to_ansi(Color fg_color, Color bg_color) {
-    static char ansi_str[128]; // Buffer for the ANSI escape sequence
-
-    snprintf(ansi_str, sizeof(ansi_str), "\033[38;2;%d;%d;%d;48;2;%d;%d;%dm",
+static char* rgb_to_ansi(char *ansi_str, size_t size, Color fg_color, Color bg_color) {
+    snprintf(ansi_str, size, "\033[38;2;%d;%d;%d;48;2;%d;%d;%dm",
              get_red(fg_color), get_green(fg_color), get_blue(fg_color),
              get_red(bg_color), get_green(bg_color), get_blue(bg_color));
 
-    return ansi_str;
+    return ansi_str;
+}
+
+/*
+ * Finds the nearest basic 8/16 color index (0-15) for RGB components.
+ * Compares squared Euclidean distances to the basic and bright palettes, basic colors win ties.
+ */
+static int rgb_to_base_index(int r, int g, int b) {
+    // Standard 8 colors followed by their bright versions
+    static const int palette[16][3] = {
+        {0, 0, 0},        // Black
+        {128, 0, 0},      // Red
+        {0, 128, 0},      // Green
+        {128, 128, 0},    // Yellow
+        {0, 0, 128},      // Blue
+        {128, 0, 128},    // Magenta
+        {0, 128, 128},    // Cyan
+        {192, 192, 192},  // Light Gray (NOT White)
+        {128, 128, 128},  // Dark Gray (Bright Black)
+        {255, 0, 0},      // Bright Red
+        {0, 255, 0},      // Bright Green
+        {255, 255, 0},    // Bright Yellow
+        {0, 0, 255},      // Bright Blue
+        {255, 0, 255},    // Bright Magenta
+        {0, 255, 255},    // Bright Cyan
+        {255, 255, 255}   // Bright White
+    };
+
+    int index = 0;
+    int min_dist = 1 << 30; // Initialize with a large value
+    for (int i = 0; i < 16; i++) {
+        int dr = r - palette[i][0];
+        int dg = g - palette[i][1];
+        int db = b - palette[i][2];
+        int dist = dr * dr + dg * dg + db * db;
+        if (dist < min_dist) {
+            min_dist = dist;
+            index = i;
+        }
+    }
+    return index;
+}
+
+/*
+ * Quantization tables
+ * The 256-color mapping is separable per channel, so it uses exact 256-entry channel tables:
+ * the 6x6x6 cube level and the range of grayscale steps a channel value is close enough to.
+ * The 16-color mapping is not separable and uses a 15-bit RGB (5 bits per channel) table instead.
+ */
+#define QUANT_TABLE_SIZE (1 << 15)
+static unsigned char quant_cube[256];           // Channel value -> cube level (0-5)
+static unsigned char quant_gray_lo[256];        // Channel value -> first matching grayscale step (24 if none)
+static unsigned char quant_gray_hi[256];        // Channel value -> last matching grayscale step
+static unsigned char quant_base[QUANT_TABLE_SIZE]; // 15-bit color -> basic color index (0-15)
+static bool quant_tables_ready = false;
+
+/*
+ * Reduces a color to its 15-bit quantization table index.
+ */
+static inline unsigned quant_index(Color color) {
+    return ((color.color >> 9) & 0x7C00) | ((color.color >> 6) & 0x03E0) | ((color.color >> 3) & 0x001F);
+}
+
+/*
+ * Builds the quantization tables.
+ * Runs the palette searches once, later calls are no-ops.
+ */
+static void build_quant_tables(void) {
+    if (quant_tables_ready) return;
+
+    float gray_step = 255.0f / 24.0f;
+    for (int c = 0; c < 256; c++) {
+        quant_cube[c] = (unsigned char)lroundf((float)c / 255.0f * 5.0f);
+
+        quant_gray_lo[c] = 24;
+        quant_gray_hi[c] = 0;
+        for (int i = 0; i < 24; i++) {
+            if (fabsf((float)(c - (8 + i * 10))) > gray_step) continue;
+            if (quant_gray_lo[c] == 24) quant_gray_lo[c] = (unsigned char)i;
+            quant_gray_hi[c] = (unsigned char)i;
+        }
+    }
+
+    for (unsigned i = 0; i < QUANT_TABLE_SIZE; i++) {
+        // Expand 5-bit channels back to 8 bits (replicating the high bits keeps 0 and 255 exact)
+        int r = (int)(((i >> 10) & 0x1F) << 3 | ((i >> 12) & 0x07));
+        int g = (int)(((i >> 5)  & 0x1F) << 3 | ((i >> 7)  & 0x07));
+        int b = (int)((i         & 0x1F) << 3 | ((i >> 2)  & 0x07));
+
+        quant_base[i] = (unsigned char)rgb_to_base_index(r, g, b);
+    }
+    quant_tables_ready = true;
+}
+
+/*
+ * Converts RGB color to the nearest index in the 256-color palette.
+ * Grayscale steps win if all channels are within one step of the same gray (the first such step is used),
+ * otherwise the color maps to the 6x6x6 color cube.
+ */
+static inline int rgb_to_256_index(Color color) {
+    int r = get_red(color);
+    int g = get_green(color);
+    int b = get_blue(color);
+
+    // Channel ranges are contiguous, so their intersection starts at the highest low bound
+    int lo = quant_gray_lo[r];
+    if (quant_gray_lo[g] > lo) lo = quant_gray_lo[g];
+    if (quant_gray_lo[b] > lo) lo = quant_gray_lo[b];
+
+    int hi = quant_gray_hi[r];
+    if (quant_gray_hi[g] < hi) hi = quant_gray_hi[g];
+    if (quant_gray_hi[b] < hi) hi = quant_gray_hi[b];
+
+    if (lo <= hi) return 232 + lo;
+
+    return 16 + 36 * quant_cube[r] + 6 * quant_cube[g] + quant_cube[b];
+}
+
+/*
+ * Converts RGB colors to the nearest ANSI escape sequence for 256-color terminals.
+ * Looks up the palette indexes in the precomputed quantization tables.
+ */
+static char* rgb_to_ansi_256(char *ansi_str, size_t size, Color fg_color, Color bg_color) {
+    snprintf(ansi_str, size, "\033[38;5;%d;48;5;%dm",
+             rgb_to_256_index(fg_color), rgb_to_256_index(bg_color));
+
+    return ansi_str;
+}
+
+/*
+ * Converts RGB colors to the nearest ANSI escape sequence for basic 8/16 color terminals.
+ * Looks up the nearest basic colors in the precomputed quantization table.
+ */
+static char *rgb_to_ansi_base(char *ansi_str, size_t size, Color fg_color, Color bg_color) {
+    int index_fg = quant_base[quant_index(fg_color)];
+    int index_bg = quant_base[quant_index(bg_color)];
+
+    // Determine ANSI color codes based on foreground and background indices
+    int fg_code = (index_fg < 8) ? (30 + index_fg) : (90 + (index_fg - 8));  // 30-37 or 90-97
+    int bg_code = (index_bg < 8) ? (40 + index_bg) : (100 + (index_bg - 8)); // 40-47 or 100-107
+
+    snprintf(ansi_str, size, "\033[%d;%dm", fg_code, bg_code);
+    return ansi_str;
+}
+
+/*
+ * Selects the appropriate ANSI escape sequence based on the terminal color mode.
+ * Uses different conversion functions based on the color mode:
+ * - Color_RGB: Uses rgb_to_ansi for TrueColor terminals
+ * - Color_256: Uses rgb_to_ansi_256 for 256-color terminals
+ * - Color_Base: Uses rgb_to_ansi_base for basic 8/16 color terminals
+ * The sequence is written to the caller's buffer, so encoder threads never share one
+ */
+static char* get_color_ansi(char *out, size_t size, Color fg_color, Color bg_color, TerminalMode mode) {
+    switch (mode) {
+        case Color_RGB:   return rgb_to_ansi(out, size, fg_color, bg_color);
+        case Color_256:   return rgb_to_ansi_256(out, size, fg_color, bg_color);
+        case Color_Base:  return rgb_to_ansi_base(out, size, fg_color, bg_color);
+        default:          return ""; // Should not happen, but return empty string for safety
+    }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//  Attribute Transition Cache
+// -----------------------------------------------------------------------------
+/*
+ * Hashes an attribute transition into a cache slot index.
+ */
+static inline unsigned sgr_cache_slot(Color foreground, Color background, TextEffect effect, TerminalMode mode) {
+    uint32_t hash = foreground.color * 0x9E3779B1u;
+    hash ^= (background.color + 0x7F4A7C15u) * 0x85EBCA6Bu;
+    hash ^= ((uint32_t)effect << 8 | (uint32_t)mode) * 0xC2B2AE35u;
+    hash ^= hash >> 15;
+    return hash & (SGR_CACHE_SIZE - 1);
+}
+
+/*
+ * Looks up the escape sequence of an attribute transition.
+ * Encodes the reset, effect and colors on a miss and stores the result in the slot.
+ */
+static const SgrCacheEntry *sgr_cache_lookup(SgrCache *cache, Color foreground, Color background, TextEffect effect, TerminalMode mode) {
+    SgrCacheEntry *entry = &cache->entries[sgr_cache_slot(foreground, background, effect, mode)];
+
+    if (entry->length                                           &&
+        entry->foreground == foreground.color                   &&
+        entry->background == background.color                   &&
+        entry->effect     == effect                             &&
+        entry->mode       == (unsigned char)mode) {
+        cache->hits++;
+        return entry;
+    }
+
+    cache->misses++;
+    char effect_sequence[16];
+    char colors[64];
+    int length = snprintf(entry->sequence, sizeof(entry->sequence), "\033[0m%s%s",
+                          get_effect_ansi(effect_sequence, sizeof(effect_sequence), effect),
+                          get_color_ansi(colors, sizeof(colors), foreground, background, mode));
+
+    entry->foreground = foreground.color;
+    entry->background = background.color;
+    entry->effect     = effect;
+    entry->mode       = (unsigned char)mode;
+    entry->length     = (unsigned char)length;
+    return entry;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//  Output Backends
+// -----------------------------------------------------------------------------
+/*
+ * Encodes a character as UTF-8.
+ * Writes up to 4 bytes into 'out' and returns their count, invalid code points become U+FFFD.
+ */
+static inline int utf8_encode(char *out, wchar_t symbol) {
+    uint32_t cp = (uint32_t)symbol;
+
+    if (cp < 0x80) {
+        out[0] = cp ? (char)cp : ' '; // NUL would end the frame on the terminal side
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp >= 0xD800 && cp <= 0xDFFF) cp = 0xFFFD; // Lone surrogates are not encodable
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    if (cp < 0x110000) {
+        out[0] = (char)(0xF0 | (cp >> 18));
+        out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (cp & 0x3F));
+        return 4;
+    }
+    return utf8_encode(out, (wchar_t)0xFFFD);
+}
+
+/*
+ * Writes the whole buffer to a file descriptor.
+ * Retries on partial writes and interrupted calls, waits for the descriptor if it is non-blocking.
+ */
+static void write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                fd_set writefds;
+                FD_ZERO(&writefds);
+                FD_SET(fd, &writefds);
+                select(fd + 1, NULL, &writefds, NULL, NULL);
+                continue;
+            }
+            return; // Terminal is gone, nothing sensible left to do
+        }
+        data += written;
+        len  -= (size_t)written;
+    }
+}
+
+/*
+ * Checks if the terminal is known to support synchronized updates (DEC mode 2026).
+ * Terminals without support ignore the mode, detection only avoids sending useless bytes.
+ */
+static bool supports_sync_updates(void) {
+    static const char *const terminals[] = {
+        "kitty", "foot", "alacritty", "wezterm", "WezTerm", "contour", "ghostty", "iTerm", "vscode", "tmux"
+    };
+
+    const char *term = getenv("TERM");
+    const char *program = getenv("TERM_PROGRAM");
+    for (size_t i = 0; i < sizeof(terminals) / sizeof(terminals[0]); i++) {
+        if (term && strstr(term, terminals[i])) return true;
+        if (program && strstr(program, terminals[i])) return true;
+    }
+    return false;
+}
+
+/*
+ * Checks if the current locale uses UTF-8.
+ * The "C"/"POSIX" locales are treated as UTF-8 too, since wprintf cannot print non-ASCII there at all.
+ */
+static bool locale_is_utf8(void) {
+    const char *locale = setlocale(LC_CTYPE, NULL);
+    if (!locale) return true;
+    if (strcmp(locale, "C") == 0 || strcmp(locale, "POSIX") == 0) return true;
+
+    return strstr(locale, "UTF-8") || strstr(locale, "utf-8") ||
+           strstr(locale, "UTF8")  || strstr(locale, "utf8");
+}
+
+/*
+ * Sets the output backend of the screen.
+ * Reallocates the render buffer for the element type of the backend.
+ * Returns false if the buffer cannot be allocated, print_screen then skips the screen.
+ */
+bool screen_set_output(Screen *screen, ScreenOutput output) {
+    if (!screen || screen->layer) return false; // Layers are never presented
+    if (screen->headless) output = Output_UTF8; // Sinks take bytes, wide output needs a terminal locale
+
+    arena_free_block(screen->buffer);
+    arena_free_block(screen->bytes);
+    screen->buffer = NULL;
+    screen->bytes = NULL;
+
+    // Both backends get the same amount of memory, UTF-8 needs up to 4 bytes per glyph
+    int wide_size = ((15) * screen->width * screen->height + 8 + screen->height) / 20;
+    if (output == Output_UTF8) {
+        screen->buffer_size = wide_size * (int)sizeof(wchar_t);
+        screen->bytes = (char *)arena_alloc(screen->arena, (size_t)(screen->buffer_size));
+    }
+    else {
+        screen->buffer_size = wide_size;
+        screen->buffer = (wchar_t *)arena_alloc(screen->arena, sizeof(wchar_t) * (size_t)(screen->buffer_size));
+    }
+    screen->output = output;
+    return screen->bytes || screen->buffer;
+}
+
+
+
+/*
+ * Enables or disables synchronized updates.
+ * With synchronized updates every frame is wrapped in begin/end markers and sent in a single write,
+ * so the terminal never rasterizes a half-written frame.
+ */
+void screen_set_sync_updates(Screen *screen, bool enabled) {
+    if (!screen) return;
+    screen->sync_updates = enabled;
+}
+
+/*
+ * Sets the frame encoder options.
+ * 'flags' is a combination of EncodeFlags. ECH and REP are off by default since not every terminal
+ * erases with the current background or implements REP.
+ */
+void screen_set_encode_flags(Screen *screen, int flags) {
+    if (!screen) return;
+    screen->encode_flags = flags;
+}
+/*
+ * Memory buffer sink.
+ * Appends to the ScreenMemorySink passed as context, what does not fit is counted as dropped.
+ */
+void screen_memory_sink(void *context, const char *data, size_t length) {
+    ScreenMemorySink *memory = (ScreenMemorySink *)context;
+    if (!memory) return;
+
+    size_t room = memory->capacity - memory->length;
+    size_t copied = (length < room) ? length : room;
+    if (copied) memcpy(memory->data + memory->length, data, copied);
+    memory->length += copied;
+    memory->dropped += length - copied;
+}
+
+/*
+ * Resets the output statistics.
+ */
+void screen_reset_stats(Screen *screen) {
+    if (!screen) return;
+    memset(&screen->stats, 0, sizeof(ScreenStats));
+}
+
+/*
+ * Grows the render buffer.
+ * Doubles the active buffer, keeping its content. Returns false if the arena is out of memory.
+ */
+static bool grow_buffer(Screen *screen, int used) {
+    size_t element = (screen->output == Output_UTF8) ? sizeof(char) : sizeof(wchar_t);
+    void *old_buffer = (screen->output == Output_UTF8) ? (void *)screen->bytes : (void *)screen->buffer;
+
+    void *new_buffer = arena_alloc(screen->arena, element * (size_t)screen->buffer_size * 2);
+    if (!new_buffer) return false;
+
+    memcpy(new_buffer, old_buffer, element * (size_t)used);
+    arena_free_block(old_buffer);
+
+    if (screen->output == Output_UTF8) screen->bytes = (char *)new_buffer;
+    else                               screen->buffer = (wchar_t *)new_buffer;
+    screen->buffer_size *= 2;
+    return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//  Style Table
+// -----------------------------------------------------------------------------
+/*
+ * Style hash
+ */
+static inline uint32_t style_hash(Color foreground, Color background, TextEffect effect) {
+    uint32_t hash = foreground.color * 0x9E3779B1u;
+    hash ^= background.color * 0x85EBCA77u + (hash >> 15);
+    hash ^= (uint32_t)effect * 0xC2B2AE3Du;
+    return hash ^ (hash >> 16);
+}
+
+/*
+ * Inserts a style id into the hash
+ * The style must not be in the hash yet
+ */
+static void insert_style_slot(ScreenStyles *styles, uint32_t id) {
+    uint32_t mask = styles->capacity * 2 - 1;
+    const ScreenStyle *style = &styles->entries[id];
+    uint32_t slot = style_hash(style->foreground, style->background, style->effect) & mask;
+    while (styles->slots[slot]) slot = (slot + 1) & mask;
+    styles->slots[slot] = id + 1;
+}
+
+/*
+ * Resizes the style table
+ * Keeps the used entries and rebuilds the hash. Returns false if the arena is out of memory
+ */
+static bool resize_styles(Screen *screen, uint32_t capacity) {
+    ScreenStyles *styles = screen->styles;
+    ScreenStyle *entries = (ScreenStyle *)arena_alloc(screen->arena, capacity * sizeof(ScreenStyle));
+    uint32_t *slots = (uint32_t *)arena_alloc(screen->arena, 2 * capacity * sizeof(uint32_t));
+    if (!entries || !slots) {
+        arena_free_block(entries);
+        arena_free_block(slots);
+        return false;
+    }
+
+    if (styles->count) memcpy(entries, styles->entries, styles->count * sizeof(ScreenStyle));
+    memset(slots, 0, 2 * capacity * sizeof(uint32_t));
+    arena_free_block(styles->entries);
+    arena_free_block(styles->slots);
+
+    styles->entries = entries;
+    styles->slots = slots;
+    styles->capacity = capacity;
+    for (uint32_t id = 0; id < styles->count; id++) insert_style_slot(styles, id);
+    return true;
+}
+
+/*
+ * Interns a style.
+ * Returns the index of (foreground, background, effect) in the style table of a packed screen,
+ * adding it if needed. Returns 0 for other layouts and SCREEN_STYLE_NONE if the table cannot grow,
+ * packed writers then leave the cell unchanged.
+ */
+uint32_t screen_intern_style(Screen *screen, Color foreground, Color background, TextEffect effect) {
+    if (!screen || !screen->styles) return 0;
+
+    ScreenStyles *styles = screen->styles;
+    uint32_t mask = styles->capacity * 2 - 1;
+    uint32_t slot = style_hash(foreground, background, effect) & mask;
+    while (styles->slots[slot]) {
+        uint32_t id = styles->slots[slot] - 1;
+        const ScreenStyle *style = &styles->entries[id];
+        if (style->foreground.color == foreground.color &&
+            style->background.color == background.color &&
+            style->effect == effect) return id;
+        slot = (slot + 1) & mask;
+    }
+
+    if (styles->count == styles->capacity) {
+        if (!resize_styles(screen, styles->capacity * 2)) return SCREEN_STYLE_NONE;
+        return screen_intern_style(screen, foreground, background, effect);
+    }
+
+    uint32_t id = styles->count++;
+    styles->entries[id] = (ScreenStyle) {foreground, background, effect};
+    styles->slots[slot] = id + 1;
+    return id;
+}
+
+/*
+ * Creates the style table of a packed screen
+ * Style 0 is the empty style every cell starts with
+ */
+static bool create_styles(Screen *screen) {
+    screen->styles = (ScreenStyles *)arena_alloc(screen->arena, sizeof(ScreenStyles));
+    if (!screen->styles) return false;
+    memset(screen->styles, 0, sizeof(ScreenStyles));
+    if (!resize_styles(screen, SCREEN_STYLE_MIN)) {
+        arena_free_block(screen->styles);
+        screen->styles = NULL;
+        return false;
+    }
+    screen->styles->compact_at = SCREEN_STYLE_MIN;
+    screen_intern_style(screen, COLOR_NONE, COLOR_NONE, Effect_None);
+    return true;
+}
+
+/*
+ * Frees the style table
+ */
+static void free_styles(Screen *screen) {
+    if (!screen->styles) return;
+    arena_free_block(screen->styles->entries);
+    arena_free_block(screen->styles->slots);
+    arena_free_block(screen->styles);
+    screen->styles = NULL;
+}
+
+/*
+ * Drops unused styles
+ * Renumbers the styles used by the back and front buffer in scan order and rewrites the cells.
+ * Only called between frames, so no caller holds a style index
+ */
+static void compact_styles(Screen *screen) {
+    ScreenStyles *styles = screen->styles;
+    uint32_t *remap = (uint32_t *)arena_alloc(screen->arena, styles->count * sizeof(uint32_t));
+    ScreenStyle *entries = (ScreenStyle *)arena_alloc(screen->arena, styles->capacity * sizeof(ScreenStyle));
+    if (!remap || !entries) {
+        arena_free_block(remap);
+        arena_free_block(entries);
+        return;
+    }
+    memset(remap, 0xFF, styles->count * sizeof(uint32_t));
+
+    uint32_t live = 0;
+    PackedCell *buffers[2] = {screen->cells, screen->front_cells};
+    for (int b = 0; b < 2 && buffers[b]; b++) { // Layers have no front buffer
+        for (int y = 0; y < screen->height; y++) {
+            PackedCell *row = buffers[b] + (size_t)y * (size_t)screen->stride;
+            for (int x = 0; x < screen->width; x++) {
+                uint32_t old = PACKED_STYLE(row[x]);
+                if (remap[old] == UINT32_MAX) {
+                    remap[old] = live;
+                    entries[live++] = styles->entries[old];
+                }
+                row[x] = PACKED_CELL(PACKED_SYMBOL(row[x]), remap[old]);
+            }
+        }
+    }
+
+    arena_free_block(remap);
+    arena_free_block(styles->entries);
+    styles->entries = entries;
+    styles->count = live;
+    memset(styles->slots, 0, 2 * styles->capacity * sizeof(uint32_t));
+    for (uint32_t id = 0; id < live; id++) insert_style_slot(styles, id);
+    styles->compact_at = (live * 2 > SCREEN_STYLE_MIN) ? live * 2 : SCREEN_STYLE_MIN;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//  Cell Storage
+// -----------------------------------------------------------------------------
+/*
+ * Allocates cell storage.
+ * Back and front buffer always share one layout, planar and packed rows are padded to
+ * SCREEN_PLANE_ALIGN bytes so every row starts on an aligned address. Render layers are never
+ * presented and get no front buffer.
+ * Returns false if the arena is out of memory, nothing is left allocated then.
+ */
+static bool alloc_storage(Screen *screen, ScreenLayout layout) {
+    size_t width = (size_t)screen->width;
+    size_t height = (size_t)screen->height;
+    int count = screen->layer ? 1 : 2; // Back buffer, front buffer
+
+    screen->layout = layout;
+    screen->pixels = NULL;
+    screen->front = NULL;
+    screen->cells = NULL;
+    screen->front_cells = NULL;
+    screen->styles = NULL;
+    screen->plane_memory = NULL;
+    memset(&screen->planes, 0, sizeof(ScreenPlanes));
+    memset(&screen->front_planes, 0, sizeof(ScreenPlanes));
+
+    if (layout == Layout_Interleaved) {
+        void *blob = arena_alloc(screen->arena, width * height * sizeof(Pixel) + sizeof(Pixel *) * height);
+        Pixel *front = (count == 2) ? (Pixel *)arena_alloc(screen->arena, width * height * sizeof(Pixel)) : NULL;
+        if (!blob || (count == 2 && !front)) {
+            arena_free_block(blob);
+            arena_free_block(front);
+            return false;
+        }
+        screen->pixels = (Pixel **)blob;
+        for (size_t i = 0; i < height; i++) {
+            screen->pixels[i] = (Pixel *)(void *)((char *)blob + sizeof(Pixel *) * height + i * width * sizeof(Pixel));
+        }
+        screen->front = front;
+        screen->stride = screen->width;
+        return true;
+    }
+
+    // One block for all buffers, every plane starts on a SCREEN_PLANE_ALIGN boundary
+    size_t element = (layout == Layout_Packed) ? sizeof(PackedCell) : sizeof(Color);
+    size_t per_line = SCREEN_PLANE_ALIGN / element;
+    size_t stride = (width + per_line - 1) / per_line * per_line;
+    size_t cells = stride * height;
+    size_t wide_plane = (cells * element + SCREEN_PLANE_ALIGN - 1) & ~(size_t)(SCREEN_PLANE_ALIGN - 1);
+    size_t effect_plane = (cells * sizeof(TextEffect) + SCREEN_PLANE_ALIGN - 1) & ~(size_t)(SCREEN_PLANE_ALIGN - 1);
+    size_t buffer = (layout == Layout_Packed) ? wide_plane : 3 * wide_plane + effect_plane;
+
+    char *plane = (char *)arena_alloc_aligned(screen->arena, (size_t)count * buffer, SCREEN_PLANE_ALIGN);
+    if (!plane) return false;
+    screen->plane_memory = plane;
+    screen->stride = (int)stride;
+
+    if (layout == Layout_Packed) {
+        screen->cells = (PackedCell *)(void *)plane;
+        screen->front_cells = (count == 2) ? (PackedCell *)(void *)(plane + wide_plane) : NULL;
+        memset(plane, 0, (size_t)count * wide_plane); // Style 0, so compaction only ever sees valid indices
+        if (create_styles(screen)) return true;
+        arena_free_block(plane);
+        screen->plane_memory = NULL;
+        screen->cells = NULL;
+        screen->front_cells = NULL;
+        return false;
+    }
+
+    ScreenPlanes *buffers[2] = {&screen->planes, &screen->front_planes};
+    for (int i = 0; i < count; i++) {
+        buffers[i]->symbol     = (wchar_t *)(void *)plane;    plane += wide_plane;
+        buffers[i]->foreground = (Color *)(void *)plane;      plane += wide_plane;
+        buffers[i]->background = (Color *)(void *)plane;      plane += wide_plane;
+        buffers[i]->effect     = (TextEffect *)(void *)plane; plane += effect_plane;
+    }
+    return true;
+}
+
+/*
+ * Frees cell storage of the active layout.
+ */
+static void free_storage(Screen *screen) {
+    arena_free_block(screen->pixels);
+    arena_free_block(screen->front);
+    arena_free_block(screen->plane_memory);
+    free_styles(screen);
+    screen->pixels = NULL;
+    screen->front = NULL;
+    screen->cells = NULL;
+    screen->front_cells = NULL;
+    screen->plane_memory = NULL;
+}
+
+/*
+ * Compare two pixels
+ * Returns true if both pixels would produce identical terminal output
+ */
+static inline bool pixel_equals(const Pixel *a, const Pixel *b) {
+    return a->symbol           == b->symbol           &&
+           a->foreground.color == b->foreground.color &&
+           a->background.color == b->background.color &&
+           a->effect           == b->effect;
+}
+
+/*
+ * Plane index of a cell
+ */
+static inline size_t plane_index(const Screen *screen, int y, int x) {
+    return (size_t)y * (size_t)screen->stride + (size_t)x;
+}
+
+/*
+ * Reads a cell
+ * Coordinates are expected to be inside the screen
+ */
+static inline Pixel cell_get(const Screen *screen, int y, int x) {
+    if (screen->layout == Layout_Interleaved) return screen->pixels[y][x];
+
+    size_t i = plane_index(screen, y, x);
+    if (screen->layout == Layout_Packed) {
+        PackedCell cell = screen->cells[i];
+        const ScreenStyle *style = &screen->styles->entries[PACKED_STYLE(cell)];
+        return (Pixel) {style->background, style->foreground, PACKED_SYMBOL(cell), style->effect};
+    }
+    return (Pixel) {screen->planes.background[i], screen->planes.foreground[i], screen->planes.symbol[i], screen->planes.effect[i]};
+}
+
+/*
+ * Restyles a packed cell
+ * Interns the cell style with one field replaced by the non-NULL argument
+ */
+static void packed_restyle(Screen *screen, size_t i, const Color *foreground, const Color *background, const TextEffect *effect) {
+    PackedCell cell = screen->cells[i];
+    ScreenStyle style = screen->styles->entries[PACKED_STYLE(cell)];
+    if (foreground) style.foreground = *foreground;
+    if (background) style.background = *background;
+    if (effect)     style.effect = *effect;
+
+    uint32_t id = screen_intern_style(screen, style.foreground, style.background, style.effect);
+    if (id == SCREEN_STYLE_NONE) return;
+    screen->cells[i] = PACKED_CELL(PACKED_SYMBOL(cell), id);
+}
+
+/*
+ * Field setters
+ * Store the value as given (COLOR_NONE included), coordinates are expected to be inside the screen
+ */
+static inline void cell_set_symbol(Screen *screen, int y, int x, wchar_t symbol) {
+    if (screen->layout == Layout_Interleaved) {
+        screen->pixels[y][x].symbol = symbol;
+        return;
+    }
+    size_t i = plane_index(screen, y, x);
+    if (screen->layout == Layout_Packed) {
+        screen->cells[i] = (screen->cells[i] & ~(PackedCell)PACKED_SYMBOL_MASK) | PACKED_CODEPOINT(symbol);
+    }
+    else screen->planes.symbol[i] = symbol;
+}
+
+static inline void cell_set_foreground(Screen *screen, int y, int x, Color foreground) {
+    if (screen->layout == Layout_Interleaved) screen->pixels[y][x].foreground = foreground;
+    else if (screen->layout == Layout_Packed) packed_restyle(screen, plane_index(screen, y, x), &foreground, NULL, NULL);
+    else screen->planes.foreground[plane_index(screen, y, x)] = foreground;
+}
+
+static inline void cell_set_background(Screen *screen, int y, int x, Color background) {
+    if (screen->layout == Layout_Interleaved) screen->pixels[y][x].background = background;
+    else if (screen->layout == Layout_Packed) packed_restyle(screen, plane_index(screen, y, x), NULL, &background, NULL);
+    else screen->planes.background[plane_index(screen, y, x)] = background;
+}
+
+static inline void cell_set_effect(Screen *screen, int y, int x, TextEffect effect) {
+    if (screen->layout == Layout_Interleaved) screen->pixels[y][x].effect = effect;
+    else if (screen->layout == Layout_Packed) packed_restyle(screen, plane_index(screen, y, x), NULL, NULL, &effect);
+    else screen->planes.effect[plane_index(screen, y, x)] = effect;
+}
+
+/*
+ * Stores a whole cell
+ */
+static inline void cell_set(Screen *screen, int y, int x, Pixel pixel) {
+    if (screen->layout == Layout_Interleaved) {
+        screen->pixels[y][x] = pixel;
+        return;
+    }
+
+    size_t i = plane_index(screen, y, x);
+    if (screen->layout == Layout_Packed) {
+        uint32_t style = screen_intern_style(screen, pixel.foreground, pixel.background, pixel.effect);
+        if (style != SCREEN_STYLE_NONE) screen->cells[i] = PACKED_CELL(pixel.symbol, style);
+        return;
+    }
+    screen->planes.symbol[i] = pixel.symbol;
+    screen->planes.foreground[i] = pixel.foreground;
+    screen->planes.background[i] = pixel.background;
+    screen->planes.effect[i] = pixel.effect;
+}
+
+/*
+ * Sets the colors of a cell
+ * COLOR_NONE keeps the current color (SET_PIXEL_COLOR semantics)
+ */
+static inline void cell_set_colors(Screen *screen, int y, int x, Color background, Color foreground) {
+    if (!is_none(foreground)) cell_set_foreground(screen, y, x, foreground);
+    if (!is_none(background)) cell_set_background(screen, y, x, background);
+}
+
+/*
+ * Draws a pixel over a cell
+ * Colors honor COLOR_NONE, the symbol is replaced and the effect kept (SET_PIXEL semantics)
+ */
+static inline void cell_blend(Screen *screen, int y, int x, Pixel pixel) {
+    cell_set_colors(screen, y, x, pixel.background, pixel.foreground);
+    cell_set_symbol(screen, y, x, pixel.symbol);
+}
+
+/*
+ * Writes text over a span
+ * Colors honor COLOR_NONE, symbol and effect are replaced. Exactly one of 'text' and 'wtext' is read
+ */
+static void span_text(Screen *screen, int y, int x, int length, const char *text, const wchar_t *wtext, Pixel style) {
+    if (screen->layout == Layout_Interleaved) {
+        Pixel *row = screen->pixels[y] + x;
+        for (int i = 0; i < length; i++) {
+            SET_PIXEL_COLOR(&row[i], style);
+            row[i].symbol = text ? (wchar_t)text[i] : wtext[i];
+            row[i].effect = style.effect;
+        }
+        return;
+    }
+
+    size_t start = plane_index(screen, y, x);
+    if (screen->layout == Layout_Packed) {
+        // Neighbouring cells mostly share a style, so only style changes are interned
+        PackedCell *row = screen->cells + start;
+        uint32_t old_style = UINT32_MAX;
+        uint32_t new_style = 0;
+        for (int i = 0; i < length; i++) {
+            uint32_t current = PACKED_STYLE(row[i]);
+            if (current != old_style) {
+                ScreenStyle merged = screen->styles->entries[current];
+                if (!is_none(style.foreground)) merged.foreground = style.foreground;
+                if (!is_none(style.background)) merged.background = style.background;
+                new_style = screen_intern_style(screen, merged.foreground, merged.background, style.effect);
+                old_style = current;
+            }
+            if (new_style == SCREEN_STYLE_NONE) continue;
+            row[i] = PACKED_CELL(text ? (wchar_t)text[i] : wtext[i], new_style);
+        }
+        return;
+    }
+
+    wchar_t *symbol = screen->planes.symbol + start;
+    TextEffect *effect = screen->planes.effect + start;
+    if (text) for (int i = 0; i < length; i++) symbol[i] = (wchar_t)text[i];
+    else      memcpy(symbol, wtext, (size_t)length * sizeof(wchar_t));
+    memset(effect, style.effect, (size_t)length * sizeof(TextEffect));
+
+    if (!is_none(style.foreground)) {
+        Color *foreground = screen->planes.foreground + start;
+        for (int i = 0; i < length; i++) foreground[i] = style.foreground;
+    }
+    if (!is_none(style.background)) {
+        Color *background = screen->planes.background + start;
+        for (int i = 0; i < length; i++) background[i] = style.background;
+    }
+}
+
+/*
+ * Copies a presented span of a row into the front buffer
+ */
+static void commit_span(Screen *screen, int y, int start, int end) {
+    size_t count = (size_t)(end - start + 1);
+    if (screen->layout == Layout_Interleaved) {
+        memcpy(screen->front + (size_t)y * (size_t)screen->width + start, screen->pixels[y] + start, count * sizeof(Pixel));
+        return;
+    }
+
+    size_t i = plane_index(screen, y, start);
+    if (screen->layout == Layout_Packed) {
+        memcpy(screen->front_cells + i, screen->cells + i, count * sizeof(PackedCell));
+        return;
+    }
+    memcpy(screen->front_planes.symbol + i,     screen->planes.symbol + i,     count * sizeof(wchar_t));
+    memcpy(screen->front_planes.foreground + i, screen->planes.foreground + i, count * sizeof(Color));
+    memcpy(screen->front_planes.background + i, screen->planes.background + i, count * sizeof(Color));
+    memcpy(screen->front_planes.effect + i,     screen->planes.effect + i,     count * sizeof(TextEffect));
+}
+
+/*
+ * Sets the cell storage layout.
+ * Converts the current content, the next print_screen repaints every cell.
+ * Keeps the current layout if the new storage cannot be allocated.
+ */
+void screen_set_layout(Screen *screen, ScreenLayout layout) {
+    if (!screen || screen->layout == layout) return;
+
+    Screen old = *screen;
+    if (!alloc_storage(screen, layout)) {
+        *screen = old;
+        return;
+    }
+    for (int y = 0; y < screen->height; y++) {
+        for (int x = 0; x < screen->width; x++) {
+            cell_set(screen, y, x, cell_get(&old, y, x));
+        }
+    }
+    free_storage(&old);
+    screen->full_redraw = true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//  Resize Signal
+// -----------------------------------------------------------------------------
+static volatile sig_atomic_t resize_pending = 0; // Set by SIGWINCH, consumed by screen_poll_resize
+
+static void on_resize(int signal) {
+    (void)signal;
+    resize_pending = 1;
+}
+
+/*
+ * Installs or removes the SIGWINCH handler
+ * Restarts interrupted reads, so input loops never see EINTR because of a resize
+ */
+static void watch_resize(bool enabled) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = enabled ? on_resize : SIG_DFL;
+    sigemptyset(&action.sa_mask);
+#ifdef SA_RESTART
+    action.sa_flags = SA_RESTART;
+#endif
+    sigaction(SIGWINCH, &action, NULL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//  Screen Initialization and Shutdown
+// -----------------------------------------------------------------------------
+/*
+ * Frees a screen structure that never reached the terminal.
+ * Used when creating a screen fails halfway, every NULL member is skipped.
+ */
+static void free_screen(Screen *screen) {
+    arena_free_block(screen->buffer);
+    arena_free_block(screen->bytes);
+    arena_free_block(screen->dirty);
+    arena_free_block(screen->sgr_cache);
+    free_storage(screen);
+    arena_free_block(screen);
+}
+
+/*
+ * Creates the screen structure.
+ * Allocates pixels, front buffer and dirty spans, the caller attaches the output. A render layer gets
+ * neither front buffer nor attribute cache.
+ * Returns NULL if the arena is out of memory.
+ */
+static Screen *create_screen(Arena *arena, int width, int height, Color background, Color foreground, wchar_t symbol,
+                             bool layer) {
+    Screen *screen = (Screen *)arena_alloc(arena, sizeof(Screen));
+    if (!screen) return NULL;
+    memset(screen, 0, sizeof(Screen));
+    screen->arena = arena;
+    screen->width = width;
+    screen->height = height;
+    screen->layer = layer;
+    build_quant_tables();
+    if (!layer) screen->sgr_cache = (SgrCache *)arena_alloc(arena, sizeof(SgrCache));
+    screen->dirty = (ScreenSpan *)arena_alloc(arena, (size_t)(height) * sizeof(ScreenSpan));
+    if ((!layer && !screen->sgr_cache) || !screen->dirty || !alloc_storage(screen, Layout_Interleaved)) {
+        free_screen(screen);
+        return NULL;
+    }
+    if (screen->sgr_cache) memset(screen->sgr_cache, 0, sizeof(SgrCache));
+
+    Pixel pixel = (Pixel) {background, foreground, symbol, Effect_None};
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            screen->pixels[i][j] = pixel;
+        }
+    }
+    screen->blank = pixel;
+    screen->full_redraw = true;
+
+    screen->dirty_top = 0;
+    screen->dirty_bottom = height - 1;
+    screen_clear_dirty(screen);
+
+    screen->encode_flags = Encode_CursorSkip;
+    return screen;
+}
+
+/*
+ * Initializes an empty screen.
+ * Creates the screen structure with cleared buffers and sets the terminal mode.
+ */
+Screen *init_screen(Arena *arena, int width, int height, Color background, Color foreground, wchar_t symbol) {
+    Screen *screen = create_screen(arena, width, height, background, foreground, symbol, false);
+    if (!screen) return NULL;
+    screen->mode = get_terminal_mode();
+
+    // The render buffer is allocated before the terminal is touched, a failed init leaves it as it was
+    setlocale(LC_ALL, "");
+    if (!screen_set_output(screen, locale_is_utf8() ? Output_UTF8 : Output_Wide)) {
+        free_screen(screen);
+        return NULL;
+    }
+
+    set_noncanonical_mode();
+    screen->sync_updates = supports_sync_updates();
+    watch_resize(true);
+
+    hide_cursor();
+    clear();
+
+    return screen;
+}
+
+/*
+ * Initializes a headless screen.
+ * No terminal is touched: frames are encoded as UTF-8 in TrueColor mode and handed to 'sink'
+ * (NULL discards them, stats are still counted). Mode and encoder options can be changed afterwards.
+ */
+Screen *init_screen_headless(Arena *arena, int width, int height, Color background, Color foreground, wchar_t symbol,
+                             ScreenSink sink, void *context) {
+    Screen *screen = create_screen(arena, width, height, background, foreground, symbol, false);
+    if (!screen) return NULL;
+    screen->mode = Color_RGB;
+    screen->headless = true;
+    screen->sink = sink;
+    screen->sink_context = context;
+
+    if (!screen_set_output(screen, Output_UTF8)) {
+        free_screen(screen);
+        return NULL;
+    }
+    return screen;
+}
+
+/*
+ * Shuts down the screen.
+ * Restores terminal settings and clears the screen.
+ */
+void screen_shutdown(Screen *screen) {
+    if (!screen) return; // defensive check
+
+    screen_stop_render_thread(screen); // Writes the last frame before the terminal is restored
+    screen_set_encode_threads(screen, 0); // Stops the band workers
+    arena_free_block(screen->buffer);  // free wide buffer
+    arena_free_block(screen->bytes);   // free UTF-8 buffer
+    arena_free_block(screen->dirty);   // free dirty spans
+    arena_free_block(screen->sgr_cache); // free attribute cache
+    free_storage(screen);              // free pixels and front buffer
+    if (screen->headless) return;      // No terminal to restore
+
+    watch_resize(false); // Default SIGWINCH disposition
+    clear();           // Clear the screen
+    show_cursor();     // Show the cursor
+    restore_terminal_settings(); // Restore terminal settings
+}
+
+
+// -----------------------------------------------------------------------------
+//  Dirty Tracking
+// -----------------------------------------------------------------------------
+/*
+ * Mark span of a row as dirty
+ * Expects already clipped coordinates
+ */
+static inline void mark_span(Screen *screen, int y, int start, int end) {
+    ScreenSpan *span = &screen->dirty[y];
+    if (start < span->start) span->start = start;
+    if (end   > span->end)   span->end   = end;
+
+    if (y < screen->dirty_top)    screen->dirty_top    = y;
+    if (y > screen->dirty_bottom) screen->dirty_bottom = y;
+}
+
+/*
+ * Mark rectangular area as dirty
+ * Clips the area to the screen, so callers can pass any rectangle
+ */
+void screen_mark_dirty(Screen *screen, int y, int x, int height, int width) {
+    if (!screen || height <= 0 || width <= 0) return;
+
+    int y_end = y + height - 1;
+    int x_end = x + width - 1;
+    if (y < 0) y = 0;
+    if (x < 0) x = 0;
+    if (y_end >= screen->height) y_end = screen->height - 1;
+    if (x_end >= screen->width)  x_end = screen->width - 1;
+
+    for (int i = y; i <= y_end && x <= x_end; i++) {
+        mark_span(screen, i, x, x_end);
+    }
+}
+
+/*
+ * Clear dirty state
+ * Marks every row as untouched, called after the frame was presented
+ */
+void screen_clear_dirty(Screen *screen) {
+    if (!screen) return;
+
+    // Only rows between dirty_top and dirty_bottom can hold a span
+    for (int y = screen->dirty_top; y <= screen->dirty_bottom; y++) {
+        screen->dirty[y] = (ScreenSpan) {screen->width, -1};
+    }
+    screen->dirty_top = screen->height;
+    screen->dirty_bottom = -1;
+}
+
+/*
+ * Check if screen has dirty rows
+ * Returns true if any drawing function touched the screen since the last present
+ */
+bool screen_is_dirty(const Screen *screen) {
+    return screen && screen->dirty_top <= screen->dirty_bottom;
+}
+
+/*
+ * Get dirty span of a row
+ * Returns false if the row was not touched, otherwise stores the touched columns in start/end
+ */
+bool screen_get_dirty_span(const Screen *screen, int y, int *start, int *end) {
+    if (!screen || y < 0 || y >= screen->height) return false;
+
+    ScreenSpan span = screen->dirty[y];
+    if (span.start > span.end) return false;
+
+    if (start) *start = span.start;
+    if (end)   *end   = span.end;
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+//  Cell Access
+// -----------------------------------------------------------------------------
+/*
+ * Get pixel at specified position
+ * Works in every layout, returns an empty pixel outside the screen
+ */
+Pixel screen_get_pixel(const Screen *screen, int y, int x) {
+    if (!screen || x < 0 || y < 0 || x >= screen->width || y >= screen->height) {
+        return (Pixel) {COLOR_NONE, COLOR_NONE, L'\0', Effect_None};
+    }
+    return cell_get(screen, y, x);
+}
+
+/*
+ * Set pixel at specified position
+ * Stores the pixel as given (no COLOR_NONE passthrough) and marks the cell dirty
+ */
+void screen_set_pixel(Screen *screen, int y, int x, Pixel pixel) {
+    if (!screen || x < 0 || y < 0 || x >= screen->width || y >= screen->height) return;
+    cell_set(screen, y, x, pixel);
+    mark_span(screen, y, x, x);
+}
+
+/*
+ * Set symbol at specified position
+ * Keeps colors and effect of the cell
+ */
+void screen_set_symbol(Screen *screen, int y, int x, wchar_t symbol) {
+    if (!screen || x < 0 || y < 0 || x >= screen->width || y >= screen->height) return;
+    cell_set_symbol(screen, y, x, symbol);
+    mark_span(screen, y, x, x);
+}
+
+/*
+ * Set foreground color at specified position
+ */
+void screen_set_foreground(Screen *screen, int y, int x, Color foreground) {
+    if (!screen || x < 0 || y < 0 || x >= screen->width || y >= screen->height) return;
+    cell_set_foreground(screen, y, x, foreground);
+    mark_span(screen, y, x, x);
+}
+
+/*
+ * Set background color at specified position
+ */
+void screen_set_background(Screen *screen, int y, int x, Color background) {
+    if (!screen || x < 0 || y < 0 || x >= screen->width || y >= screen->height) return;
+    cell_set_background(screen, y, x, background);
+    mark_span(screen, y, x, x);
+}
+
+
+// -----------------------------------------------------------------------------
+//  Render Layers
+// -----------------------------------------------------------------------------
+/*
+ * Creates a render layer.
+ * A transparent cell buffer of the screen size: every cell starts as COLOR_NONE colors and an L'\0'
+ * glyph. Drawing functions work on it as on any screen, it has no output and print_screen ignores it.
+ */
+Screen *screen_create_layer(Screen *screen) {
+    if (!screen) return NULL;
+
+    Screen *layer = create_screen(screen->arena, screen->width, screen->height, COLOR_NONE, COLOR_NONE, L'\0', true);
+    if (!layer) return NULL;
+    layer->mode = screen->mode;
+    layer->headless = true;
+    screen_mark_dirty(layer, 0, 0, layer->height, layer->width); // The first composite covers every cell
+    return layer;
+}
+
+/*
+ * Clears a screen or render layer.
+ * Resets every cell to the fill the screen was created with, a layer becomes fully transparent.
+ */
+void screen_clear_layer(Screen *layer) {
+    if (!layer) return;
+
+    for (int y = 0; y < layer->height; y++) {
+        for (int x = 0; x < layer->width; x++) cell_set(layer, y, x, layer->blank);
+    }
+    screen_mark_dirty(layer, 0, 0, layer->height, layer->width);
+}
+
+/*
+ * Composites a render layer over a screen.
+ * COLOR_NONE colors keep the color below, an L'\0' glyph keeps the glyph and effect below.
+ * Only the dirty spans of the layer are composited, a new or cleared layer is dirty everywhere.
+ * The caller clears them with screen_clear_dirty once the layer is composited. Only cells whose
+ * result differs are written and marked dirty, so compositing an unchanged layer costs no output.
+ */
+void screen_composite(Screen *screen, const Screen *layer) {
+    if (!screen || !layer) return;
+    int height = (layer->height < screen->height) ? layer->height : screen->height;
+    int width = (layer->width < screen->width) ? layer->width : screen->width;
+    int bottom = (layer->dirty_bottom < height) ? layer->dirty_bottom : height - 1;
+
+    for (int y = layer->dirty_top; y <= bottom; y++) {
+        int start, end;
+        if (!screen_get_dirty_span(layer, y, &start, &end)) continue;
+        if (end >= width) end = width - 1;
+
+        int first = -1;
+        int last = -1;
+        for (int x = start; x <= end; x++) {
+            Pixel top = cell_get(layer, y, x);
+            if (top.symbol == L'\0' && is_none(top.foreground) && is_none(top.background)) continue;
+
+            Pixel below = cell_get(screen, y, x);
+            Pixel result = below;
+            if (!is_none(top.background)) result.background = top.background;
+            if (!is_none(top.foreground)) result.foreground = top.foreground;
+            if (top.symbol != L'\0') {
+                result.symbol = top.symbol;
+                result.effect = top.effect;
+            }
+            if (pixel_equals(&result, &below)) continue;
+
+            cell_set(screen, y, x, result);
+            if (first < 0) first = x;
+            last = x;
+        }
+        if (first >= 0) mark_span(screen, y, first, last);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+//  Clipping
+// -----------------------------------------------------------------------------
+/*
+ * Active clip rectangle
+ * Top of the clip stack limited to the screen, the whole screen when the stack is empty
+ */
+static inline ScreenClip active_clip(const Screen *screen) {
+    ScreenClip clip = {0, 0, screen->height, screen->width, 0, 0};
+    if (screen->clip_depth == 0) return clip;
+
+    // Pushed rectangles may predate a resize, so the screen bounds are applied on use
+    const ScreenClip *top = &screen->clips[screen->clip_depth - 1];
+    if (top->top > clip.top)       clip.top = top->top;
+    if (top->left > clip.left)     clip.left = top->left;
+    if (top->bottom < clip.bottom) clip.bottom = top->bottom;
+    if (top->right < clip.right)   clip.right = top->right;
+    clip.origin_y = top->origin_y;
+    clip.origin_x = top->origin_x;
+    return clip;
+}
+
+/*
+ * Clips a horizontal span given in screen coordinates
+ * Returns false if nothing of it is visible, otherwise narrows x/length to the visible part
+ */
+static inline bool clip_span(const ScreenClip *clip, int y, int *x, int *length) {
+    if (y < clip->top || y >= clip->bottom) return false;
+
+    int start = (*x > clip->left) ? *x : clip->left;
+    int end = (*x + *length < clip->right) ? *x + *length : clip->right;
+    if (start >= end) return false;
+
+    *x = start;
+    *length = end - start;
+    return true;
+}
+
+/*
+ * Checks if a cell given in screen coordinates is visible
+ */
+static inline bool clip_cell(const ScreenClip *clip, int y, int x) {
+    return y >= clip->top && y < clip->bottom && x >= clip->left && x < clip->right;
+}
+
+/*
+ * Pushes a clip rectangle
+ */
+static bool push_clip(Screen *screen, int y, int x, int height, int width, bool translate) {
+    if (!screen || screen->clip_depth >= SCREEN_CLIP_DEPTH) return false;
+
+    ScreenClip parent = active_clip(screen);
+    y += parent.origin_y;
+    x += parent.origin_x;
+
+    // Nested rectangles never reach outside the one they are pushed into
+    ScreenClip clip = parent;
+    if (y > clip.top)                  clip.top = y;
+    if (x > clip.left)                 clip.left = x;
+    if (y + height < clip.bottom)      clip.bottom = y + height;
+    if (x + width < clip.right)        clip.right = x + width;
+    if (clip.bottom < clip.top)        clip.bottom = clip.top;
+    if (clip.right < clip.left)        clip.right = clip.left;
+    if (translate) {
+        clip.origin_y = y;
+        clip.origin_x = x;
+    }
+
+    screen->clips[screen->clip_depth++] = clip;
+    return true;
+}
+
+/*
+ * Pushes a clip rectangle.
+ * Drawing functions only touch cells inside the rectangle (and every rectangle below it on the stack),
+ * coordinates keep their origin. Returns false if the stack is full.
+ */
+bool screen_push_clip(Screen *screen, int y, int x, int height, int width) {
+    return push_clip(screen, y, x, height, width, false);
 }
 
 /*
- * Converts RGB color to the nearest index in the 256-color palette.
- * It first checks for grayscale colors and maps them to the corresponding index,
- * then maps the RGB values to the 6x6x6 color cube and returns the corresponding index.
+ * Pushes a viewport.
+ * Like screen_push_clip, but the top-left corner of the rectangle also becomes drawing
+ * position (0, 0), so objects can be drawn into a panel without knowing where it is.
  */
-static int rgb_to_256_index(Color color) {
-    int r = get_red(color);
-    int g = get_green(color);
-    int b = get_blue(color);
+bool screen_push_viewport(Screen *screen, int y, int x, int height, int width) {
+    return push_clip(screen, y, x, height, width, true);
+}
 
-    // Check for grayscale colors first
-    int gray_index = -1;
-    float gray_step = 255.0f / 24.0f;
-    for (int i = 0; i < 24; i++) {
-        int gray_val = 8 + i * 10;
+/*
+ * Pops the last pushed clip rectangle or viewport.
+ */
+void screen_pop_clip(Screen *screen) {
+    if (!screen || screen->clip_depth == 0) return;
+    screen->clip_depth--;
+}
+
+
+// -----------------------------------------------------------------------------
+//  Drawing Functions
+// -----------------------------------------------------------------------------
+/*
+ * Add borders to specified area of screen
+ * Creates a border using provided border characters
+ */
+void add_borders(Screen *screen, int y, int x, int height, int width, Color background, Color foreground, const wchar_t *borders) {
+    if (!screen || !borders) return; // Check for NULL pointers
+    if (height <= 0 || width <= 0) return; //basic checks
+
+    ScreenClip clip = active_clip(screen);
+    y += clip.origin_y;
+    x += clip.origin_x;
+    int bottom = y + height - 1;
+    int right = x + width - 1;
+
+    // Draw horizontal borders (top and bottom), only their visible part
+    int span_x = x;
+    int span_length = width;
+    if (clip_span(&clip, y, &span_x, &span_length)) {
+        screen_fill_span(screen, y, span_x, span_length, borders[0], background, foreground);
+    }
+    span_x = x;
+    span_length = width;
+    if (clip_span(&clip, bottom, &span_x, &span_length)) {
+        screen_fill_span(screen, bottom, span_x, span_length, borders[0], background, foreground);
+    }
 
-        if (fabsf((float)(r - gray_val)) <= gray_step &&
-            fabsf((float)(g - gray_val)) <= gray_step &&
-            fabsf((float)(b - gray_val)) <= gray_step) {
-            gray_index = 232 + i;
-            break;
+    // Draw vertical borders (left and right)
+    Pixel vertical_pixel = (Pixel) {background, foreground, borders[1], Effect_None};
+    int first = (y > clip.top) ? y : clip.top;
+    int last = (bottom < clip.bottom - 1) ? bottom : clip.bottom - 1;
+    for (int i = first; i <= last; ++i) {
+        if (x >= clip.left && x < clip.right) {
+            cell_blend(screen, i, x, vertical_pixel);
+            mark_span(screen, i, x, x);
+        }
+        if (right >= clip.left && right < clip.right) {
+            cell_blend(screen, i, right, vertical_pixel);
+            mark_span(screen, i, right, right);
         }
     }
-    if (gray_index >= 0) return gray_index;
 
-    // If not grayscale, map to the 6x6x6 color cube
-    int r_6 = (int)lroundf((float)r / 255.0f * 5.0f);
-    int g_6 = (int)lroundf((float)g / 255.0f * 5.0f);
-    int b_6 = (int)lroundf((float)b / 255.0f * 5.0f);
+    // Set corner characters
+    if (clip_cell(&clip, y, x))          cell_set_symbol(screen, y, x, borders[2]);          // Top-left
+    if (clip_cell(&clip, y, right))      cell_set_symbol(screen, y, right, borders[3]);      // Top-right
+    if (clip_cell(&clip, bottom, x))     cell_set_symbol(screen, bottom, x, borders[4]);     // Bottom-left
+    if (clip_cell(&clip, bottom, right)) cell_set_symbol(screen, bottom, right, borders[5]); // Bottom-right
+}
+
+/*
+ * Add separator line to screen
+ * Used for visual separation of screen areas
+ */
+void add_separator(Screen *screen, int y, int x, Color background, Color foreground , const wchar_t *borders) {
+    if (!screen || !borders) return;
+
+    // The separator runs to the right edge of the active clip rectangle
+    ScreenClip clip = active_clip(screen);
+    y += clip.origin_y;
+    x += clip.origin_x;
+    int right = clip.right - 1;
 
-    return 16 + 36 * r_6 + 6 * g_6 + b_6;
+    int span_x = x;
+    int span_length = right - x + 1;
+    if (span_length <= 0 || !clip_span(&clip, y, &span_x, &span_length)) return;
+
+    screen_fill_span(screen, y, span_x, span_length, borders[0], background, foreground);
+    // Set separator start/end characters
+    if (x >= clip.left) cell_set_symbol(screen, y, x, borders[6]);
+    cell_set_symbol(screen, y, right, borders[7]);
 }
 
 /*
- * Converts RGB colors to the nearest ANSI escape sequence for 256-color terminals.
- * It first converts the RGB values to the nearest index in the 256-color palette,
- * then returns the corresponding ANSI escape sequence.
+ * Render state shared by the encoding helpers
+ * Tracks the write position in the render buffer and the attributes the terminal currently uses
  */
-static char* rgb_to_ansi_256(Color fg_color, Color bg_color) {
-    static char ansi_str[64]; // Buffer for the ANSI escape sequence
+typedef struct {
+    int        idx;         // Current write position in the render buffer
+    int        cursor_y;    // Row of the terminal cursor (-1 if unknown)
+    int        cursor_x;    // Column of the terminal cursor
+    Color      last_bg;     // Background currently set on the terminal
+    Color      last_fg;     // Foreground currently set on the terminal
+    TextEffect last_effect; // Effect currently set on the terminal
+    uint32_t   last_style;  // Packed style matching the terminal attributes (UINT32_MAX if unknown)
+    long long  write_ns;    // Time spent in flushes of this frame
+} RenderState;
 
-    snprintf(ansi_str, sizeof(ansi_str), "\033[38;5;%d;48;5;%dm",
-             rgb_to_256_index(fg_color), rgb_to_256_index(bg_color));
+/*
+ * Monotonic time in nanoseconds
+ */
+static inline long long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
 
-    return ansi_str;
+/*
+ * Bytes queued for the terminal
+ * Output the kernel accepted but the terminal has not read yet, 0 where TIOCOUTQ is not available
+ */
+static size_t terminal_queued_bytes(void) {
+#ifdef TIOCOUTQ
+    int queued = 0;
+    if (ioctl(STDOUT_FILENO, TIOCOUTQ, &queued) == 0 && queued > 0) return (size_t)queued;
+#endif
+    return 0;
 }
 
 /*
- * Converts RGB colors to the nearest ANSI escape sequence for basic 8/16 color terminals.
- * It first calculates the Euclidean distance between the RGB values and the basic colors,
- * then selects the closest color and returns the corresponding ANSI escape sequence.
- */
-static char *rgb_to_ansi_base(Color fg_color, Color bg_color) {
-    static char ansi_str[32];  // Buffer for the ANSI escape sequence
-    int r_fg = get_red(fg_color);
-    int g_fg = get_green(fg_color);
-    int b_fg = get_blue(fg_color);
-
-    int r_bg = get_red(bg_color);
-    int g_bg = get_green(bg_color);
-    int b_bg = get_blue(bg_color);
-
-    // Find the closest basic color index for foreground
-    int index_fg = 0;
-    float min_dist_fg = 1e9f; // Initialize with a large value
-
-    // Find the closest basic color index for background
-    int index_bg = 0;
-    float min_dist_bg = 1e9f;
-
-    // Standard 8 colors (black, red, green, yellow, blue, magenta, cyan, white)
-    int basic_colors[8][3] = {
-        {0, 0, 0},      // Black
-        {128, 0, 0},    // Red
-        {0, 128, 0},    // Green
-        {128, 128, 0},  // Yellow
-        {0, 0, 128},    // Blue
-        {128, 0, 128},  // Magenta
-        {0, 128, 128},  // Cyan
-        {192, 192, 192} // Light Gray (NOT White)
-    };
+ * Flush render buffer
+ * Sends the buffered part of the frame to the terminal using the active backend
+ */
+static void flush_buffer(Screen *screen, RenderState *state) {
+    if (state->idx == 0) return;
 
-    // Bright 8 colors (corresponding bright versions)
-    int bright_colors[8][3] = {
-        {128, 128, 128},  // Dark Gray (Bright Black)
-        {255, 0, 0},      // Bright Red
-        {0, 255, 0},      // Bright Green
-        {255, 255, 0},    // Bright Yellow
-        {0, 0, 255},      // Bright Blue
-        {255, 0, 255},    // Bright Magenta
-        {0, 255, 255},    // Bright Cyan
-        {255, 255, 255}   // Bright White
-    };
+    screen->stats.total_bytes += (size_t)state->idx;
+    long long start = now_ns();
+    if (screen->headless) {
+        if (screen->sink) screen->sink(screen->sink_context, screen->bytes, (size_t)state->idx);
+    }
+    else if (screen->output == Output_UTF8) {
+        fflush(stdout); // Keep ordering with anything printed through stdio
+        write_all(STDOUT_FILENO, screen->bytes, (size_t)state->idx);
+    }
+    else {
+        screen->buffer[state->idx] = L'\0'; // Null-terminate the string
+        wprintf(L"%ls", screen->buffer);    // Print the buffer
+        fflush(stdout);
+    }
+    state->write_ns += now_ns() - start;    // Blocks while the terminal queue is full
+    state->idx = 0;                         // Reset the index
+}
 
-    // Calculate Euclidean distance to find the closest basic color (foreground)
-    for (int i = 0; i < 8; i++) {
-        float dist = (float)sqrt(pow(r_fg - basic_colors[i][0], 2) +
-                                 pow(g_fg - basic_colors[i][1], 2) +
-                                 pow(b_fg - basic_colors[i][2], 2));
-        if (dist < min_dist_fg) {
-            min_dist_fg = dist;
-            index_fg = i;
-        }
-        // Calculate Euclidean distance for background
-        dist = (float)sqrt(pow(r_bg - basic_colors[i][0], 2) +
-                           pow(g_bg - basic_colors[i][1], 2) +
-                           pow(b_bg - basic_colors[i][2], 2));
-        if (dist < min_dist_bg) {
-            min_dist_bg = dist;
-            index_bg = i;
-        }
-    }
-
-    // Calculate Euclidean distance to find the closest bright color (foreground)
-    for (int i = 0; i < 8; i++) {
-        float dist = (float)sqrt(pow(r_fg - bright_colors[i][0], 2) +
-                                 pow(g_fg - bright_colors[i][1], 2) +
-                                 pow(b_fg - bright_colors[i][2], 2));
-        if (dist < min_dist_fg) {
-            min_dist_fg = dist;
-            index_fg = i + 8; // Offset index for bright colors
-        }
-        //background
-        dist = (float)sqrt(pow(r_bg - bright_colors[i][0], 2) +
-                           pow(g_bg - bright_colors[i][1], 2) +
-                           pow(b_bg - bright_colors[i][2], 2));
-        if (dist < min_dist_bg) {
-            min_dist_bg = dist;
-            index_bg = i + 8;
-        }
+/*
+ * Flush render buffer if full
+ * Flushes if the next sequence might not fit. With synchronized updates the buffer grows instead,
+ * so the frame still goes out in one write
+ */
+static inline void flush_if_full(Screen *screen, RenderState *state) {
+    if (state->idx > screen->buffer_size - MAX_ANSI_LENGTH) {
+        if (screen->sync_updates && grow_buffer(screen, state->idx)) return;
+        flush_buffer(screen, state);
     }
-    // Determine ANSI color codes based on foreground and background indices
-    int fg_code = (index_fg < 8) ? (30 + index_fg) : (90 + (index_fg - 8));  // 30-37 or 90-97
-    int bg_code = (index_bg < 8) ? (40 + index_bg) : (100 + (index_bg - 8)); // 40-47 or 100-107
+}
 
-    snprintf(ansi_str, sizeof(ansi_str), "\033[%d;%dm", fg_code, bg_code);
-    return ansi_str;
+/*
+ * Emit ASCII sequence
+ * Appends an escape sequence (or any ASCII string) to the render buffer
+ */
+static inline void emit_ascii(Screen *screen, RenderState *state, const char *str) {
+    if (screen->output == Output_UTF8) {
+        while (*str) screen->bytes[state->idx++] = *str++;
+    }
+    else {
+        while (*str) screen->buffer[state->idx++] = (wchar_t)*str++;
+    }
 }
 
 /*
- * Selects the appropriate ANSI escape sequence based on the terminal color mode.
- * Uses different conversion functions based on the color mode:
- * - Color_RGB: Uses rgb_to_ansi for TrueColor terminals
- * - Color_256: Uses rgb_to_ansi_256 for 256-color terminals
- * - Color_Base: Uses rgb_to_ansi_base for basic 8/16 color terminals
+ * Emit bytes
+ * Appends 'length' ASCII bytes to the render buffer
  */
-static char* get_color_ansi(Color fg_color, Color bg_color, TerminalMode mode) {
-    switch (mode) {
-        case Color_RGB:   return rgb_to_ansi(fg_color, bg_color);
-        case Color_256:   return rgb_to_ansi_256(fg_color, bg_color);
-        case Color_Base:  return rgb_to_ansi_base(fg_color, bg_color);
-        default:          return ""; // Should not happen, but return empty string for safety
+static inline void emit_bytes(Screen *screen, RenderState *state, const char *data, int length) {
+    if (screen->output == Output_UTF8) {
+        memcpy(screen->bytes + state->idx, data, (size_t)length);
+        state->idx += length;
+    }
+    else {
+        for (int i = 0; i < length; i++) screen->buffer[state->idx++] = (wchar_t)data[i];
     }
 }
 
+/*
+ * Emit glyph
+ * Appends a single cell symbol to the render buffer
+ */
+static inline void emit_glyph(Screen *screen, RenderState *state, wchar_t symbol) {
+    if (screen->output == Output_UTF8) {
+        state->idx += utf8_encode(screen->bytes + state->idx, symbol);
+    }
+    else {
+        screen->buffer[state->idx++] = symbol;
+    }
+}
 
+/*
+ * Format unsigned integer
+ * Writes decimal digits of 'value' into 'out' and returns the pointer past the last digit
+ */
+static inline char *format_uint(char *out, unsigned value) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (count) *out++ = digits[--count];
+    return out;
+}
 
-// -----------------------------------------------------------------------------
-//  Screen Initialization and Shutdown
-// -----------------------------------------------------------------------------
 /*
- * Initializes an empty screen.
- * Creates the screen structure with cleared buffers and sets the terminal mode.
+ * Emit cursor position
+ * Appends an absolute cursor position (CUP) sequence for zero-based coordinates
  */
-Screen *init_screen(Arena *arena, int width, int height, Color background, Color foreground, wchar_t symbol) {
-    Screen *screen = (Screen *)arena_alloc(arena, sizeof(Screen));
-    screen->width = width;
-    screen->height = height;
-    screen->mode = get_terminal_mode();
-    
-    void *blob = arena_alloc(arena, (size_t)(width * height) * sizeof(Pixel) + sizeof(Pixel *) * (size_t)(height));
-    screen->pixels = (Pixel **)blob;
+static inline void emit_cursor_position(Screen *screen, RenderState *state, int y, int x) {
+    char sequence[24] = "\033[";
+    char *end = format_uint(sequence + 2, (unsigned)(y + 1));
+    *end++ = ';';
+    end = format_uint(end, (unsigned)(x + 1));
+    *end++ = 'H';
+    *end = '\0';
+    emit_ascii(screen, state, sequence);
+}
 
-    Pixel pixel = (Pixel) {background, foreground, symbol, Effect_None};
-    for (int i = 0; i < height; i++) {
-        screen->pixels[i] = (Pixel *)(void *)((char *)blob + sizeof(Pixel *) * (size_t)(height) + (size_t)(i) * (size_t)(width) * sizeof(Pixel));
-        for (int j = 0; j < width; j++) {
-            screen->pixels[i][j] = pixel;
+/*
+ * Format color parameter
+ * Writes the SGR parameter selecting 'color' as foreground (base 30) or background (base 40)
+ * in the given terminal mode and returns the pointer past the last written character
+ */
+static char *format_color_param(char *out, Color color, int base, TerminalMode mode) {
+    switch (mode) {
+        case Color_RGB:
+            out = format_uint(out, (unsigned)(base + 8));
+            *out++ = ';'; *out++ = '2'; *out++ = ';';
+            out = format_uint(out, get_red(color));   *out++ = ';';
+            out = format_uint(out, get_green(color)); *out++ = ';';
+            return format_uint(out, get_blue(color));
+        case Color_256:
+            out = format_uint(out, (unsigned)(base + 8));
+            *out++ = ';'; *out++ = '5'; *out++ = ';';
+            return format_uint(out, (unsigned)rgb_to_256_index(color));
+        case Color_Base: {
+            int index = quant_base[quant_index(color)];
+            // 30-37/40-47 for basic colors, 90-97/100-107 for bright ones
+            return format_uint(out, (unsigned)((index < 8) ? (base + index) : (base + 60 + index - 8)));
         }
+        default:
+            return out;
     }
-    
-    screen->buffer_size = ((15) * screen->width * screen->height + 8 + screen->height) / 20;
-    screen->buffer = (wchar_t *)arena_alloc(arena, sizeof(wchar_t) * (size_t)(screen->buffer_size));
+}
 
-    set_noncanonical_mode();
-    setlocale(LC_ALL, "");
-    hide_cursor();
-    clear();
+/*
+ * Emit attribute change
+ * Switches the terminal to the attributes of 'px' with as few parameters as possible:
+ * only the changed effect/foreground/background are sent, and a reset is used only
+ * when an active effect has to be cleared
+ */
+static void emit_attributes(Screen *screen, RenderState *state, const Pixel *px) {
+    bool fg_changed = px->foreground.color != state->last_fg.color;
+    bool bg_changed = px->background.color != state->last_bg.color;
+    bool effect_changed = px->effect != state->last_effect;
+
+    if (effect_changed && state->last_effect != Effect_None) {
+        // Effects can only be cleared by a reset, which drops colors too
+        const SgrCacheEntry *sgr = sgr_cache_lookup(screen->sgr_cache, px->foreground, px->background, px->effect, screen->mode);
+        emit_bytes(screen, state, sgr->sequence, sgr->length);
+    }
+    else {
+        char sequence[SGR_MAX_LENGTH] = "\033[";
+        char *end = sequence + 2;
+        if (effect_changed) {
+            end = format_uint(end, px->effect);
+        }
+        if (fg_changed) {
+            if (end != sequence + 2) *end++ = ';';
+            end = format_color_param(end, px->foreground, 30, screen->mode);
+        }
+        if (bg_changed) {
+            if (end != sequence + 2) *end++ = ';';
+            end = format_color_param(end, px->background, 40, screen->mode);
+        }
+        *end++ = 'm';
+        emit_bytes(screen, state, sequence, (int)(end - sequence));
+    }
 
-    return screen;
+    // Update last known colors/effect
+    state->last_bg = px->background;
+    state->last_fg = px->foreground;
+    state->last_effect = px->effect;
 }
 
 /*
- * Shuts down the screen.
- * Restores terminal settings and clears the screen.
+ * Emit control sequence with a count
+ * Appends CSI <count> <final>, used for cursor-forward, erase and repeat
  */
-void screen_shutdown(Screen *screen) {
-    if (!screen) return; // defensive check
+static inline void emit_csi_count(Screen *screen, RenderState *state, int count, char final) {
+    char sequence[16] = "\033[";
+    char *end = format_uint(sequence + 2, (unsigned)count);
+    *end++ = final;
+    *end = '\0';
+    emit_ascii(screen, state, sequence);
+}
 
-    arena_free_block(screen->buffer);  // free buffer
-    arena_free_block(screen->pixels);  // free pixels
-    clear();           // Clear the screen
-    show_cursor();     // Show the cursor
-    restore_terminal_settings(); // Restore terminal settings
+/*
+ * Move cursor to the start of a run
+ * Uses cursor-forward if the cursor already is on the same row (and skipping is enabled),
+ * an absolute position otherwise
+ */
+static inline void move_cursor(Screen *screen, RenderState *state, int y, int x) {
+    if ((screen->encode_flags & Encode_CursorSkip) && state->cursor_y == y && state->cursor_x <= x) {
+        if (x > state->cursor_x) emit_csi_count(screen, state, x - state->cursor_x, 'C');
+    }
+    else {
+        emit_cursor_position(screen, state, y, x);
+    }
+    state->cursor_y = y;
+    state->cursor_x = x;
+}
+
+/*
+ * Encode a run of pixels
+ * Positions the cursor at the start of the run and writes every cell up to 'end' inclusive,
+ * copying written cells into the front buffer. Runs of identical cells are sent as ECH/REP
+ * when enabled in encode_flags
+ */
+static void encode_run(Screen *screen, RenderState *state, int y, int start, int end) {
+    flush_if_full(screen, state);
+    move_cursor(screen, state, y, start);
+
+    bool rle = screen->encode_flags & (Encode_EraseChars | Encode_Repeat);
+    const PackedCell *cells = (screen->layout == Layout_Packed) ? screen->cells + plane_index(screen, y, 0) : NULL;
+
+    int x = start;
+    while (x <= end) {
+        Pixel px = cell_get(screen, y, x);
+        flush_if_full(screen, state);
+
+        // Check if colors or effect have changed, packed cells with the terminal style skip the compare
+        uint32_t style = cells ? PACKED_STYLE(cells[x]) : UINT32_MAX;
+        if (!(cells && style == state->last_style) &&
+            (px.background.color != state->last_bg.color ||
+             px.foreground.color != state->last_fg.color ||
+             px.effect != state->last_effect)) {
+            emit_attributes(screen, state, &px);
+        }
+        state->last_style = style;
+
+        int count = 1;
+        if (rle && cells) {
+            while (x + count <= end && cells[x + count] == cells[x]) count++;
+        }
+        else if (rle) {
+            while (x + count <= end) {
+                Pixel next = cell_get(screen, y, x + count);
+                if (!pixel_equals(&px, &next)) break;
+                count++;
+            }
+        }
+
+        int cursor_step = count; // Columns the terminal cursor moves
+        if (count >= SCREEN_RLE_MIN && (screen->encode_flags & Encode_EraseChars) &&
+            px.symbol == L' ' && px.effect == Effect_None) {
+            // Erase leaves the cursor in place, step over the cells only if the run goes on
+            flush_if_full(screen, state);
+            emit_csi_count(screen, state, count, 'X');
+            if (x + count <= end) emit_csi_count(screen, state, count, 'C');
+            else                  cursor_step = 0;
+        }
+        else if (count >= SCREEN_RLE_MIN && (screen->encode_flags & Encode_Repeat)) {
+            flush_if_full(screen, state);
+            emit_glyph(screen, state, px.symbol);
+            emit_csi_count(screen, state, count - 1, 'b');
+        }
+        else {
+            for (int i = 0; i < count; i++) {
+                flush_if_full(screen, state);
+                emit_glyph(screen, state, px.symbol);
+            }
+        }
+
+        state->cursor_x = x + cursor_step;
+        x += count;
+    }
+    commit_span(screen, y, start, end);
+}
+
+/*
+ * Encode dirty rows
+ * Sends the changed cells of rows 'top' to 'bottom'. Changed cells separated by only a few unchanged
+ * ones are merged into one run, every run starts with a cursor movement (absolute for the first run
+ * of a row). Returns true if anything was encoded
+ */
+static bool encode_rows(Screen *screen, RenderState *state, int top, int bottom) {
+    bool changed = false;
+    int gap = (screen->encode_flags & Encode_CursorSkip) ? SCREEN_SKIP_GAP : SCREEN_DIFF_GAP;
+
+    for (int y = top; y <= bottom; ++y) {
+        ScreenSpan span = screen->dirty[y];
+        if (span.start > span.end) continue;
+
+        // Full redraw sends the whole span as one run
+        if (screen->full_redraw) {
+            encode_run(screen, state, y, span.start, span.end);
+            changed = true;
+            continue;
+        }
+
+        int x = screen_find_change(screen, y, span.start, span.end);
+        while (x <= span.end) {
+            // Extend the run while the unchanged gap stays short enough
+            int start = x;
+            int end = x;
+            for (;;) {
+                int limit = (end + gap < span.end) ? end + gap : span.end;
+                int next = screen_find_change(screen, y, end + 1, limit);
+                if (next > limit) break;
+                end = next;
+            }
+
+            encode_run(screen, state, y, start, end);
+            changed = true;
+            x = screen_find_change(screen, y, end + 1, span.end);
+        }
+    }
+    return changed;
 }
 
 
+
 // -----------------------------------------------------------------------------
-//  Drawing Functions
+//  Parallel Encoding
 // -----------------------------------------------------------------------------
 /*
- * Add borders to specified area of screen
- * Creates a border using provided border characters
+ * Row band
+ * Encodes a contiguous range of rows into a private buffer, band 0 runs on the calling thread
  */
-void add_borders(Screen *screen, int y, int x, int height, int width, Color background, Color foreground, const wchar_t *borders) {
-    if (!screen || !borders) return; // Check for NULL pointers
-    if (y < 0 || x < 0 || height <= 0 || width <= 0) return; //basic checks
-    if (y + height > screen->height || x + width > screen->width) return;
+typedef struct EncodeBand {
+    ScreenEncoder *encoder;
+    Screen screen;       // Copy of the screen with the band buffer and attribute cache
+    RenderState state;   // Encoder state, starts with the attributes the serial encoder would have
+    int top;             // First row
+    int bottom;          // Last row (top > bottom when empty)
+    bool changed;        // Anything was encoded
+    void *memory;        // Band buffer
+    size_t memory_size;  // Band buffer size in bytes
+    SgrCache *sgr_cache; // Private attribute cache, the screen cache is not thread-safe
+} EncodeBand;
 
-    // Draw horizontal borders (top and bottom)
-    Pixel horizontal_pixel = (Pixel) {background, foreground, borders[0], Effect_None};
-    for (int i = 0; i < width; ++i) {
-        SET_PIXEL(&screen->pixels[y][x + i], horizontal_pixel);
-        SET_PIXEL(&screen->pixels[y + height - 1][x + i], horizontal_pixel);
-    }
+/*
+ * Row-band encoder pool
+ * Workers sleep on 'start' until 'generation' changes, the last one to finish signals 'done'
+ */
+struct ScreenEncoder {
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    pthread_t *threads;     // One worker per band after the first
+    EncodeBand *bands;
+    int count;              // Bands per frame
+    int workers;            // Started worker threads
+    int pending;            // Workers still encoding the current frame
+    unsigned long generation;
+    bool running;
+};
 
-    // Draw vertical borders (left and right)
-    Pixel vertical_pixel = (Pixel) {background, foreground, borders[1], Effect_None};
-    for (int i = 0; i < height; ++i) {
-        SET_PIXEL(&screen->pixels[y + i][x], vertical_pixel);
-        SET_PIXEL(&screen->pixels[y + i][x + width - 1], vertical_pixel);
+/*
+ * Band worker
+ */
+static void *encode_worker(void *arg) {
+    EncodeBand *band = (EncodeBand *)arg;
+    ScreenEncoder *encoder = band->encoder;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&encoder->lock);
+    for (;;) {
+        while (encoder->running && encoder->generation == seen) pthread_cond_wait(&encoder->start, &encoder->lock);
+        if (!encoder->running) break;
+        seen = encoder->generation;
+        pthread_mutex_unlock(&encoder->lock);
+
+        band->changed = encode_rows(&band->screen, &band->state, band->top, band->bottom);
+
+        pthread_mutex_lock(&encoder->lock);
+        if (--encoder->pending == 0) pthread_cond_signal(&encoder->done);
     }
-
-    // Set corner characters
-    screen->pixels[y][x].symbol = borders[2];                          // Top-left
-    screen->pixels[y][x + width - 1].symbol = borders[3];              // Top-right
-    screen->pixels[y + height - 1][x].symbol = borders[4];             // Bottom-left
-    screen->pixels[y + height - 1][x + width - 1].symbol = borders[5]; // Bottom-right
+    pthread_mutex_unlock(&encoder->lock);
+    return NULL;
 }
 
 /*
- * Add separator line to screen
- * Used for visual separation of screen areas
+ * Stops the worker pool
  */
-void add_separator(Screen *screen, int y, int x, Color background, Color foreground , const wchar_t *borders) {
-    if (!screen || !borders) return;
-    if (y < 0 || x < 0) return;
-    if (y >= screen->height || x >= screen->width) return;
-
-    Pixel pixel = (Pixel) {background, foreground, borders[0], Effect_Bold}; // Use bold effect
-    for (int i = 0; i < screen->width; ++i) {
-        SET_PIXEL(&screen->pixels[y][x + i], pixel);
+static void stop_encoder(Screen *screen) {
+    ScreenEncoder *encoder = screen->encoder;
+    if (!encoder) return;
+
+    pthread_mutex_lock(&encoder->lock);
+    encoder->running = false;
+    pthread_cond_broadcast(&encoder->start);
+    pthread_mutex_unlock(&encoder->lock);
+    for (int i = 0; i < encoder->workers; i++) pthread_join(encoder->threads[i], NULL);
+
+    pthread_cond_destroy(&encoder->done);
+    pthread_cond_destroy(&encoder->start);
+    pthread_mutex_destroy(&encoder->lock);
+    for (int i = 0; i < encoder->count; i++) {
+        arena_free_block(encoder->bands[i].memory);
+        arena_free_block(encoder->bands[i].sgr_cache);
     }
-    // Set separator start/end characters
-    screen->pixels[y][x].symbol = borders[6];
-    screen->pixels[y][screen->width - 1].symbol = borders[7];
+    arena_free_block(encoder->threads);
+    arena_free_block(encoder->bands);
+    arena_free_block(encoder);
+    screen->encoder = NULL;
 }
 
 /*
- * Print screen content to terminal
- * Outputs the entire screen buffer with formatting
+ * Sets the number of encoder threads.
+ * With more than one thread, large frames are split into row bands that are encoded in parallel
+ * and sent in order, the output is byte-identical to the serial encoder. Returns false if the
+ * workers could not be started, the screen then encodes serially.
  */
-void print_screen(const Screen *screen) {
-    if (!screen) return;
+bool screen_set_encode_threads(Screen *screen, int threads) {
+    if (!screen) return false;
+    stop_encoder(screen);
+    if (threads <= 1) return true;
+    if (threads > screen->height) threads = screen->height;
+
+    ScreenEncoder *encoder = (ScreenEncoder *)arena_alloc(screen->arena, sizeof(ScreenEncoder));
+    if (!encoder) return false;
+    memset(encoder, 0, sizeof(ScreenEncoder));
+    encoder->bands = (EncodeBand *)arena_alloc(screen->arena, (size_t)threads * sizeof(EncodeBand));
+    encoder->threads = (pthread_t *)arena_alloc(screen->arena, (size_t)threads * sizeof(pthread_t));
+    if (!encoder->bands || !encoder->threads) {
+        arena_free_block(encoder->bands);
+        arena_free_block(encoder->threads);
+        arena_free_block(encoder);
+        return false;
+    }
+    memset(encoder->bands, 0, (size_t)threads * sizeof(EncodeBand));
+    pthread_mutex_init(&encoder->lock, NULL);
+    pthread_cond_init(&encoder->start, NULL);
+    pthread_cond_init(&encoder->done, NULL);
+
+    // Each band holds at most ceil(height / threads) rows of the worst case encoding
+    size_t rows = (size_t)((screen->height + threads - 1) / threads);
+    size_t size = rows * (size_t)screen->width * SCREEN_BAND_CELL_BYTES + 2 * MAX_ANSI_LENGTH;
+    encoder->count = threads;
+    encoder->running = true;
+    screen->encoder = encoder;
+    for (int i = 0; i < threads; i++) {
+        EncodeBand *band = &encoder->bands[i];
+        band->encoder = encoder;
+        band->memory_size = size * sizeof(wchar_t); // Room for either backend
+        band->memory = arena_alloc(screen->arena, band->memory_size);
+        band->sgr_cache = (SgrCache *)arena_alloc(screen->arena, sizeof(SgrCache));
+        if (!band->memory || !band->sgr_cache) {
+            stop_encoder(screen);
+            return false;
+        }
+        memset(band->sgr_cache, 0, sizeof(SgrCache));
+    }
 
-    int buf_idx = 0;
+    screen_get_simd(); // Select the kernels before the workers can race on it
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&encoder->threads[i - 1], NULL, encode_worker, &encoder->bands[i]) != 0) {
+            stop_encoder(screen);
+            return false;
+        }
+        encoder->workers++;
+    }
+    return true;
+}
 
-    // Move cursor to the top-left corner (home position)
-    buf_idx += swprintf(screen->buffer + buf_idx, MAX_ANSI_LENGTH, L"\033[0;0H");
+/*
+ * Attributes on band entry
+ * The serial encoder enters row 'top' with the attributes of the last cell it sent above,
+ * which is the last changed cell (or the span end on full redraw) of the nearest row with changes
+ */
+static void band_entry_state(const Screen *screen, RenderState *band, const RenderState *frame, int first, int top) {
+    band->last_bg = frame->last_bg;
+    band->last_fg = frame->last_fg;
+    band->last_effect = frame->last_effect;
+
+    for (int y = top - 1; y >= first; y--) {
+        ScreenSpan span = screen->dirty[y];
+        if (span.start > span.end) continue;
+
+        int x = screen->full_redraw ? span.end : screen_find_change_reverse(screen, y, span.start, span.end);
+        if (x < span.start) continue;
+
+        Pixel px = cell_get(screen, y, x);
+        band->last_bg = px.background;
+        band->last_fg = px.foreground;
+        band->last_effect = px.effect;
+        return;
+    }
+}
 
-    // Initialize last colors/effect to a value that won't match any real pixel
-    Color last_bg = COLOR_NONE;
-    Color last_fg = COLOR_NONE;
-    TextEffect last_effect = Effect_None;
+/*
+ * Appends a band to the render buffer
+ * Copies in chunks that fit, flushing (or growing with synchronized updates) in between
+ */
+static void append_band(Screen *screen, RenderState *state, const EncodeBand *band) {
+    int offset = 0;
+    while (offset < band->state.idx) {
+        flush_if_full(screen, state);
+        int room = screen->buffer_size - 1 - state->idx; // Wide output needs room for the terminator
+        int chunk = band->state.idx - offset;
+        if (chunk > room) chunk = room;
+
+        if (screen->output == Output_UTF8) {
+            memcpy(screen->bytes + state->idx, band->screen.bytes + offset, (size_t)chunk);
+        }
+        else {
+            memcpy(screen->buffer + state->idx, band->screen.buffer + offset, (size_t)chunk * sizeof(wchar_t));
+        }
+        state->idx += chunk;
+        offset += chunk;
+    }
+}
 
-    for (int y = 0; y < screen->height; ++y) {
-        for (int x = 0; x < screen->width; ++x) {
-            Pixel px = screen->pixels[y][x];
+/*
+ * Encode dirty rows in parallel
+ * Splits the dirty rows into bands, every band starts with an absolute cursor position (a new row)
+ * and the attributes the serial encoder would have there. Returns true if anything was encoded
+ */
+static bool encode_bands(Screen *screen, RenderState *state) {
+    ScreenEncoder *encoder = screen->encoder;
+    int top = screen->dirty_top;
+    int rows = screen->dirty_bottom - top + 1;
+
+    for (int i = 0; i < encoder->count; i++) {
+        EncodeBand *band = &encoder->bands[i];
+        band->top = top + (int)((long)rows * i / encoder->count);
+        band->bottom = top + (int)((long)rows * (i + 1) / encoder->count) - 1;
+        band->changed = false;
+
+        // Private buffer that never flushes: it is sized for the worst case, overflow is discarded
+        band->screen = *screen;
+        band->screen.encoder = NULL;
+        band->screen.renderer = NULL;
+        band->screen.headless = true;
+        band->screen.sink = NULL;
+        band->screen.sync_updates = false;
+        band->screen.sgr_cache = band->sgr_cache;
+        band->screen.bytes = (char *)band->memory;
+        band->screen.buffer = (wchar_t *)band->memory;
+        band->screen.buffer_size = (int)(band->memory_size / ((screen->output == Output_UTF8) ? sizeof(char) : sizeof(wchar_t)));
+
+        band->state = (RenderState) {
+            .idx = 0,
+            .cursor_y = -1,
+            .cursor_x = 0,
+            .last_style = UINT32_MAX
+        };
+        band_entry_state(screen, &band->state, state, top, band->top);
+    }
 
-            // Buffer overflow check
-            if ((int)buf_idx > screen->buffer_size - MAX_ANSI_LENGTH) {
-                screen->buffer[buf_idx] = L'\0'; // Null-terminate the string
-                wprintf(L"%ls", screen->buffer); // Print the buffer
-                buf_idx = 0;                     // Reset the index
-            }
+    pthread_mutex_lock(&encoder->lock);
+    encoder->pending = encoder->count - 1;
+    encoder->generation++;
+    pthread_cond_broadcast(&encoder->start);
+    pthread_mutex_unlock(&encoder->lock);
+
+    EncodeBand *first = &encoder->bands[0];
+    first->changed = encode_rows(&first->screen, &first->state, first->top, first->bottom);
+
+    pthread_mutex_lock(&encoder->lock);
+    while (encoder->pending > 0) pthread_cond_wait(&encoder->done, &encoder->lock);
+    pthread_mutex_unlock(&encoder->lock);
+
+    bool changed = false;
+    for (int i = 0; i < encoder->count; i++) {
+        EncodeBand *band = &encoder->bands[i];
+        if (!band->changed) continue;
+        append_band(screen, state, band);
+        state->cursor_y = band->state.cursor_y;
+        state->cursor_x = band->state.cursor_x;
+        state->last_bg = band->state.last_bg;
+        state->last_fg = band->state.last_fg;
+        state->last_effect = band->state.last_effect;
+        changed = true;
+    }
+    return changed;
+}
 
-            // Check if colors or effect have changed
-            if (px.background.color != last_bg.color ||
-                px.foreground.color != last_fg.color ||
-                px.effect != last_effect) {
-
-                // Combine reset, effect, and color setting into one escape sequence
-                buf_idx += swprintf(screen->buffer + buf_idx, MAX_ANSI_LENGTH,
-                                    L"\033[0m%s%s", // Reset and then set new attributes
-                                    get_effect_ansi(px.effect),
-                                    get_color_ansi(px.foreground, px.background, screen->mode)
-                                    );
-                // Update last known colors/effect
-                last_bg = px.background;
-                last_fg = px.foreground;
-                last_effect = px.effect;
-            }
+/*
+ * Print screen content to terminal
+ * Outputs only the cells that changed since the last presented frame, scanning dirty spans only.
+ * Large frames are encoded in row bands when encoder threads are set.
+ * With a render thread the frame is only published, encoding happens on that thread
+ */
+void print_screen(Screen *screen) {
+    if (!screen) return;
+    if (!screen->bytes && !screen->buffer) return; // Render layer, composited instead of printed
+    if (screen->renderer) {
+        screen_publish_frame(screen); // Encoded and written by the render thread
+        return;
+    }
 
-            // Add the character to the buffer
-            screen->buffer[buf_idx++] = px.symbol;
-        }
-        screen->buffer[buf_idx++] = L'\n'; // Add a newline at the end of each row
+    // Every frame ends with a reset, so the terminal starts in its default state (no colors, no effect)
+    RenderState state = {
+        .idx = 0,
+        .cursor_y = -1,
+        .cursor_x = 0,
+        .last_bg = COLOR_NONE,
+        .last_fg = COLOR_NONE,
+        .last_effect = Effect_None,
+        .last_style = UINT32_MAX,
+        .write_ns = 0
+    };
+    size_t sent = screen->stats.total_bytes;
+    if (screen->sync_updates) emit_ascii(screen, &state, SYNC_UPDATE_BEGIN);
+
+    // Full redraw repaints everything, otherwise only spans touched since the last present are scanned
+    if (screen->full_redraw) screen_mark_dirty(screen, 0, 0, screen->height, screen->width);
+
+    bool changed;
+    long area = (long)(screen->dirty_bottom - screen->dirty_top + 1) * screen->width;
+    if (screen->encoder && area >= SCREEN_BAND_MIN_CELLS) changed = encode_bands(screen, &state);
+    else changed = encode_rows(screen, &state, screen->dirty_top, screen->dirty_bottom);
+
+    screen->full_redraw = false;
+    screen_clear_dirty(screen);
+    if (screen->styles && screen->styles->count >= screen->styles->compact_at) compact_styles(screen);
+    if (changed) {
+        flush_if_full(screen, &state);
+        emit_ascii(screen, &state, "\033[0m"); // Reset attributes at the end of the frame
+        if (screen->sync_updates) emit_ascii(screen, &state, SYNC_UPDATE_END);
+        flush_buffer(screen, &state);
+    } // Nothing to send otherwise, the begin marker is dropped
+
+    screen->stats.frames++;
+    screen->stats.last_write_ns = state.write_ns;
+    screen->stats.queued_bytes = screen->headless ? 0 : terminal_queued_bytes();
+    screen->stats.last_frame_bytes = screen->stats.total_bytes - sent;
+    if (screen->stats.last_frame_bytes > screen->stats.peak_frame_bytes) {
+        screen->stats.peak_frame_bytes = screen->stats.last_frame_bytes;
     }
+}
 
-    screen->buffer[buf_idx] = L'\0';        // Null-terminate the string
-    wprintf(L"%ls\033[0m", screen->buffer); // Print the entire buffer and reset
+/*
+ * Force full redraw
+ * Discards the front buffer so the next print_screen repaints every cell
+ */
+void screen_force_redraw(Screen *screen) {
+    if (!screen) return;
+    screen->full_redraw = true;
 }
 
 
@@ -468,28 +2213,37 @@ void print_screen(const Screen *screen) {
  */
 void put_pixel(Screen *screen, int y, int x, wchar_t symbol, Color background, Color foreground, TextEffect effect) {
     if (!screen) return; // NULL check
-    if (x < 0 || y < 0) return;
-    if (x >= screen->width || y >= screen->height) return;
+
+    ScreenClip clip = active_clip(screen);
+    y += clip.origin_y;
+    x += clip.origin_x;
+    if (!clip_cell(&clip, y, x)) return;
 
     Pixel pixel = (Pixel) {background, foreground, symbol, effect}; // Create the pixel
-    SET_PIXEL(&screen->pixels[y][x], pixel); // Set the pixel using the macro
+    cell_blend(screen, y, x, pixel); // Colors honor COLOR_NONE like SET_PIXEL
+    mark_span(screen, y, x, x);
 }
 
 
 /*
  * Fill rectangular area with specified symbol
- * Fills the area with specified symbol, background and foreground formatting
+ * Fills the visible part of the area with specified symbol, background and foreground formatting
  */
 void fill_area(Screen *screen, int y, int x, int height, int width, wchar_t symbol, Color background, Color foreground) {
     if (!screen) return; // NULL check
-    if (x < 0 || y < 0 || height <= 0 || width <= 0) return;
-    if (x + width > screen->width || y + height > screen->height) return;
-
-    Pixel pixel = (Pixel) {background, foreground, symbol, Effect_None}; // Create the pixel
-    for (int i = y; i < y + height; i++) {
-        for (int j = x; j < x + width; j++) {
-            SET_PIXEL(&screen->pixels[i][j], pixel); // Set the pixel using the macro
-        }
+    if (height <= 0 || width <= 0) return;
+
+    ScreenClip clip = active_clip(screen);
+    y += clip.origin_y;
+    x += clip.origin_x;
+    int first = (y > clip.top) ? y : clip.top;
+    int last = (y + height < clip.bottom) ? y + height : clip.bottom;
+
+    int span_x = x;
+    int span_length = width;
+    if (first >= last || !clip_span(&clip, first, &span_x, &span_length)) return;
+    for (int i = first; i < last; i++) {
+        screen_fill_span(screen, i, span_x, span_length, symbol, background, foreground); // Marks the span dirty
     }
 }
 
@@ -499,22 +2253,22 @@ void fill_area(Screen *screen, int y, int x, int height, int width, wchar_t symb
  */
 void insert_text(Screen *screen, int y, int x, const char *text, Color foreground, Color background, TextEffect effect) {
     if (!screen || !text) return; // Check for NULL pointers
-    if(x < 0 || y < 0) return;
-    if (y >= screen->height || x >= screen->width) return;
+
+    ScreenClip clip = active_clip(screen);
+    y += clip.origin_y;
+    x += clip.origin_x;
 
     int text_length;
     for (text_length = 0; text[text_length] != '\0'; text_length++);
 
-    if (x + text_length > screen->width) {
-        text_length = screen->width - x;  // Truncate if text goes beyond screen width
-    }
-    
+    // Truncate on both sides, characters left of the clip rectangle are skipped
+    int start = x;
+    if (!clip_span(&clip, y, &start, &text_length)) return;
+    int skip = start - x;
+
     Pixel pixel = (Pixel) {background, foreground, ' ', effect};
-    for (int i = 0; i < text_length; i++) {
-        SET_PIXEL(&screen->pixels[y][x + i], pixel);
-        screen->pixels[y][x + i].symbol = text[i];
-        screen->pixels[y][x + i].effect = effect;
-    }
+    span_text(screen, y, start, text_length, text + skip, NULL, pixel);
+    mark_span(screen, y, start, start + text_length - 1);
 }
 
 /*
@@ -523,22 +2277,22 @@ void insert_text(Screen *screen, int y, int x, const char *text, Color foregroun
  */
 void insert_wtext(Screen *screen, int y, int x, const wchar_t *text, Color foreground, Color background, TextEffect effect) {
     if (!screen || !text) return; // Check for NULL pointers
-    if(x < 0 || y < 0) return;
-    if (y >= screen->height || x >= screen->width) return;
+
+    ScreenClip clip = active_clip(screen);
+    y += clip.origin_y;
+    x += clip.origin_x;
 
     int text_length;
     for (text_length = 0; text[text_length] != L'\0'; text_length++);
 
-    if (x + text_length > screen->width) {
-        text_length = screen->width - x;  // Truncate if text goes beyond screen width
-    }
-    
+    // Truncate on both sides, characters left of the clip rectangle are skipped
+    int start = x;
+    if (!clip_span(&clip, y, &start, &text_length)) return;
+    int skip = start - x;
+
     Pixel pixel = (Pixel) {background, foreground, ' ', effect};
-    for (int i = 0; i < text_length; i++) {
-        SET_PIXEL(&screen->pixels[y][x + i], pixel);
-        screen->pixels[y][x + i].symbol = text[i];
-        screen->pixels[y][x + i].effect = effect;
-    }
+    span_text(screen, y, start, text_length, NULL, text + skip, pixel);
+    mark_span(screen, y, start, start + text_length - 1);
 }
 
 
@@ -595,30 +2349,106 @@ static const wchar_t* get_cursor_string(CursorType type) {
  */
 void screen_draw_cursor(Screen *screen, Coords coords, CursorConfig config) {
     if (!screen) return;
-    if (coords.x < 0 || coords.y < 0 || coords.x >= screen->width || coords.y >= screen->height) return;
+
+    ScreenClip clip = active_clip(screen);
+    coords.y = (short)(coords.y + clip.origin_y);
+    coords.x = (short)(coords.x + clip.origin_x);
+    if (!clip_cell(&clip, coords.y, coords.x)) return;
 
     const wchar_t *cursor_string = get_cursor_string(config.type);
     if (!cursor_string) return;
 
 
-    Pixel *main_pixel = &screen->pixels[coords.y][coords.x];
-    SET_PIXEL_COLOR(main_pixel, config);
-    main_pixel->effect = config.effect;
+    cell_set_colors(screen, coords.y, coords.x, config.background, config.foreground);
+    cell_set_effect(screen, coords.y, coords.x, config.effect);
+    mark_span(screen, coords.y, coords.x, coords.x);
 
-    main_pixel->symbol = cursor_string[0];
+    cell_set_symbol(screen, coords.y, coords.x, cursor_string[0]);
     // Handle wide cursors (which occupy two cells)
     if (config.type > CURSOR_WIDE) {
-        main_pixel->symbol = cursor_string[1];
+        cell_set_symbol(screen, coords.y, coords.x, cursor_string[1]);
         int dx = (cursor_string[0] == L'H') ? 1 : 0; // Horizontal cursor: second char is to the right
         int dy = (cursor_string[0] == L'V') ? 1 : 0; // Vertical cursor: second char is below
 
         //bounds check
-        if (coords.x + dx < screen->width && coords.y + dy < screen->height){
-            Pixel *second_pixel = &screen->pixels[coords.y + dy][coords.x + dx];
-            second_pixel->symbol = cursor_string[2];
-            SET_PIXEL_COLOR(second_pixel, config);
+        if (clip_cell(&clip, coords.y + dy, coords.x + dx)) {
+            cell_set_symbol(screen, coords.y + dy, coords.x + dx, cursor_string[2]);
+            cell_set_colors(screen, coords.y + dy, coords.x + dx, config.background, config.foreground);
+            mark_span(screen, coords.y + dy, coords.x + dx, coords.x + dx);
+        }
+    }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//  Screen Resize
+// -----------------------------------------------------------------------------
+/*
+ * Resizes the screen.
+ * Reallocates cells, front buffer, dirty spans and render buffer. Content of the overlapping area
+ * is kept, new cells get the fill the screen was created with. Render and encoder threads are
+ * restarted for the new size, the next print_screen repaints every cell.
+ */
+bool screen_resize(Screen *screen, int width, int height) {
+    if (!screen || width <= 0 || height <= 0) return false;
+    if (width == screen->width && height == screen->height) return true;
+
+    // Both thread kinds hold buffers sized for the old screen
+    bool threaded = screen->renderer != NULL;
+    int threads = screen->encoder ? screen->encoder->count : 0;
+    screen_stop_render_thread(screen);
+    screen_set_encode_threads(screen, 0);
+
+    Screen old = *screen;
+    screen->width = width;
+    screen->height = height;
+    ScreenSpan *dirty = (ScreenSpan *)arena_alloc(screen->arena, (size_t)(height) * sizeof(ScreenSpan));
+    if (!dirty || !alloc_storage(screen, old.layout)) {
+        arena_free_block(dirty);
+        *screen = old; // Keeps the old size, threads are restarted as they were
+        if (threads) screen_set_encode_threads(screen, threads);
+        if (threaded) screen_start_render_thread(screen);
+        return false;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool kept = y < old.height && x < old.width;
+            cell_set(screen, y, x, kept ? cell_get(&old, y, x) : screen->blank);
         }
     }
+    free_storage(&old);
+
+    arena_free_block(screen->dirty);
+    screen->dirty = dirty;
+    screen->dirty_top = 0;
+    screen->dirty_bottom = height - 1;
+    screen_clear_dirty(screen);
+    if (screen->layer) screen_mark_dirty(screen, 0, 0, height, width); // Composited again as a whole
+    bool output = true;
+    if (screen->bytes || screen->buffer) {
+        output = screen_set_output(screen, screen->output); // Render buffer is sized by the cell count, layers have none
+    }
+    screen->full_redraw = true;
+
+    if (threads) screen_set_encode_threads(screen, threads);
+    if (threaded) screen_start_render_thread(screen);
+    return output;
+}
+
+/*
+ * Follows the terminal size.
+ * After a SIGWINCH, queries the size with TIOCGWINSZ and resizes the screen to it.
+ * Returns true if the screen was resized, the caller redraws its content.
+ */
+bool screen_poll_resize(Screen *screen) {
+    if (!screen || screen->headless || !resize_pending) return false;
+    resize_pending = 0;
+
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_col == 0 || size.ws_row == 0) return false;
+    if (size.ws_col == screen->width && size.ws_row == screen->height) return false;
+    return screen_resize(screen, size.ws_col, size.ws_row);
 }
 
 #endif // CUSTOM_SCREEN
@@ -12,6 +12,20 @@
 //  Constants and Macros
 // -----------------------------------------------------------------------------
 #define MAX_ANSI_LENGTH 50 // Define a reasonable maximum for ANSI sequences
+#define SCREEN_DIFF_GAP 8  // Unchanged cells tolerated inside one run before a cursor jump pays off
+#define SCREEN_SKIP_GAP 4  // Same, when unchanged spans are skipped with cursor-forward (CUF)
+#define SCREEN_RLE_MIN  8  // Shortest run of identical cells worth an erase/repeat sequence
+#define SGR_CACHE_SIZE  256 // Number of cached attribute transitions (power of two)
+#define SGR_MAX_LENGTH  48  // Longest encoded transition: reset + effect + two 24-bit colors
+#define SCREEN_PLANE_ALIGN 64 // Alignment of planar rows in bytes (one cache line)
+#define SCREEN_STYLE_MIN   256 // Initial style table size of the packed layout
+#define SCREEN_STYLE_NONE  UINT32_MAX // screen_intern_style result when the style table cannot grow
+#define SCREEN_BAND_MIN_CELLS  8192 // Smallest dirty area split into row bands
+#define SCREEN_BAND_CELL_BYTES (SGR_MAX_LENGTH + 24) // Encoded size bound of one cell: position, attributes, glyph
+#define SCREEN_CLIP_DEPTH      16 // Nesting limit of clip rectangles
+
+#define SYNC_UPDATE_BEGIN "\033[?2026h" // Terminal holds rendering until the matching end
+#define SYNC_UPDATE_END   "\033[?2026l"
 
 #ifndef CUSTOM_SCREEN // Allow users to provide their own screen implementation
 
@@ -60,6 +74,188 @@ typedef enum {
     Color_RGB   // TrueColor (RGB) mode
 } TerminalMode;
 
+/*
+ * Screen output backends
+ * UTF-8 encodes cells into a byte buffer and writes it with write(2)
+ * Wide goes through wprintf and the locale conversion of libc (fallback for non UTF-8 locales)
+ */
+typedef enum {
+    Output_UTF8, // Hand-rolled UTF-8 encoding, single write(2) per flush
+    Output_Wide  // wchar_t buffer printed with wprintf
+} ScreenOutput;
+
+
+/*
+ * Cell storage layouts
+ * Interleaved keeps Pixel structs behind row pointers ('pixels'), planar keeps one contiguous plane per field
+ */
+typedef enum {
+    Layout_Interleaved, // Array of Pixel structs (default, 'pixels' is valid)
+    Layout_Planar,      // Separate symbol/foreground/background/effect planes ('pixels' is NULL)
+    Layout_Packed       // 8-byte cells: codepoint + index into the style table ('pixels' is NULL)
+} ScreenLayout;
+
+/*
+ * Planar cell storage
+ * Cell (y, x) lives at index y * stride + x of every plane
+ */
+typedef struct ScreenPlanes {
+    wchar_t    *symbol;     // Glyph plane
+    Color      *foreground; // Foreground color plane
+    Color      *background; // Background color plane
+    TextEffect *effect;     // Effect plane
+} ScreenPlanes;
+
+/*
+ * Packed cell
+ * Codepoint in the low 21 bits, style table index above. Codepoints outside Unicode are stored as U+FFFD
+ */
+typedef uint64_t PackedCell;
+
+#define PACKED_SYMBOL_BITS 21
+#define PACKED_SYMBOL_MASK 0x1FFFFFu
+#define PACKED_CODEPOINT(symbol) (((uint32_t)(symbol) < 0x110000u) ? (uint32_t)(symbol) : 0xFFFDu)
+#define PACKED_CELL(symbol, style) (((PackedCell)(style) << PACKED_SYMBOL_BITS) | (PackedCell)PACKED_CODEPOINT(symbol))
+#define PACKED_SYMBOL(cell) ((wchar_t)((cell) & PACKED_SYMBOL_MASK))
+#define PACKED_STYLE(cell)  ((uint32_t)((cell) >> PACKED_SYMBOL_BITS))
+
+/*
+ * Cell style
+ * Attribute tuple shared by all packed cells with the same style index
+ */
+typedef struct ScreenStyle {
+    Color      foreground; // Foreground color
+    Color      background; // Background color
+    TextEffect effect;     // Text effect
+} ScreenStyle;
+
+/*
+ * Style table of the packed layout
+ * Every tuple is stored once, so equal styles always have equal indices.
+ * Unused styles are dropped after a present once the table reached 'compact_at'
+ */
+typedef struct ScreenStyles {
+    ScreenStyle *entries;  // Interned styles, the index is the style id
+    uint32_t *slots;       // Open addressing hash of style ids (id + 1, 0 = empty), 2 * capacity slots
+    uint32_t count;        // Used entries
+    uint32_t capacity;     // Allocated entries
+    uint32_t compact_at;   // Entry count that triggers compaction
+} ScreenStyles;
+
+
+/*
+ * Frame encoder options
+ * Bit flags selecting cheaper escape sequences for unchanged spans and runs of identical cells
+ */
+typedef enum {
+    Encode_None       = 0,
+    Encode_CursorSkip = 1 << 0, // Skip unchanged spans inside a row with cursor-forward (CUF)
+    Encode_EraseChars = 1 << 1, // Send runs of blank cells as erase-character (ECH), needs background color erase
+    Encode_Repeat     = 1 << 2  // Send runs of identical cells as repeat (REP)
+} EncodeFlags;
+
+/*
+ * Instruction set levels of the frame diff and fill kernels
+ */
+typedef enum {
+    Simd_Auto,   // Best level the CPU supports
+    Simd_Scalar, // Portable loops
+    Simd_SSE2,   // 128-bit kernels (x86-64 baseline)
+    Simd_AVX2    // 256-bit kernels
+} SimdLevel;
+
+/*
+ * Dirty span of a single screen row
+ * Columns [start, end] were touched since the last present, start > end means the row is clean
+ */
+typedef struct ScreenSpan {
+    int start; // First touched column
+    int end;   // Last touched column
+} ScreenSpan;
+
+/*
+ * Clip rectangle and viewport origin
+ * Rows [top, bottom) and columns [left, right) in screen coordinates, drawing coordinates are
+ * offset by (origin_y, origin_x)
+ */
+typedef struct ScreenClip {
+    int top;      // First visible row
+    int left;     // First visible column
+    int bottom;   // Row past the last visible one
+    int right;    // Column past the last visible one
+    int origin_y; // Screen row of drawing row 0
+    int origin_x; // Screen column of drawing column 0
+} ScreenClip;
+
+
+/*
+ * Byte sink of a headless screen
+ * Receives every encoded chunk of a frame instead of stdout
+ */
+typedef void (*ScreenSink)(void *context, const char *data, size_t length);
+
+/*
+ * Memory buffer sink
+ * Caller-owned buffer collecting headless output, bytes past capacity are counted in 'dropped'
+ */
+typedef struct ScreenMemorySink {
+    char  *data;     // Destination buffer
+    size_t capacity; // Size of the destination buffer
+    size_t length;   // Bytes stored so far
+    size_t dropped;  // Bytes that did not fit
+} ScreenMemorySink;
+
+/*
+ * Output statistics
+ * Counted for every presented frame, frames without changes count as 0 bytes. With a render thread
+ * the output thread counts the frames it presents, print_screen collects them on the drawing thread
+ * one frame late. Dropped frames are not counted (see screen_dropped_frames)
+ */
+typedef struct ScreenStats {
+    unsigned long frames;     // Presented frames
+    size_t last_frame_bytes;  // Bytes sent by the last frame
+    size_t peak_frame_bytes;  // Largest frame so far
+    size_t total_bytes;       // Bytes sent since init or the last reset (wchar_t elements for wide output)
+    long long last_write_ns;  // Time the last frame spent in write calls (or the sink)
+    size_t queued_bytes;      // Bytes still queued for the terminal after the last frame (TIOCOUTQ, 0 if unknown)
+} ScreenStats;
+
+
+/*
+ * Cached attribute transition
+ * Ready-to-copy escape bytes switching the terminal to (foreground, background, effect) in a given mode
+ */
+typedef struct SgrCacheEntry {
+    uint32_t      foreground;               // Foreground color of the transition
+    uint32_t      background;               // Background color of the transition
+    TextEffect    effect;                   // Text effect of the transition
+    unsigned char mode;                     // TerminalMode the sequence was encoded for
+    unsigned char length;                   // Length of the sequence, 0 for an empty slot
+    char          sequence[SGR_MAX_LENGTH]; // Encoded escape bytes (not null-terminated)
+} SgrCacheEntry;
+
+/*
+ * Attribute transition cache
+ * Direct-mapped hash of encoded SGR sequences with hit/miss counters
+ */
+typedef struct SgrCache {
+    SgrCacheEntry entries[SGR_CACHE_SIZE]; // Cache slots
+    unsigned long hits;                    // Lookups served from the cache
+    unsigned long misses;                  // Lookups that had to encode the sequence
+} SgrCache;
+
+
+/*
+ * Render thread state
+ * Private to screen_render.c, see screen_start_render_thread
+ */
+typedef struct ScreenRenderer ScreenRenderer;
+
+/*
+ * Row-band encoder pool
+ * Private to screen.c, see screen_set_encode_threads
+ */
+typedef struct ScreenEncoder ScreenEncoder;
 
 /*
  * Screen structure
@@ -68,12 +264,45 @@ typedef enum {
 struct Screen {
     int height;        // Screen height in pixels
     int width;         // Screen width in pixels
-    Pixel **pixels;    // 2D array of pixel data
+    Pixel **pixels;    // 2D array of pixel data (Layout_Interleaved only)
+    Pixel *front;      // Last presented frame (width * height), used to diff against
+    bool full_redraw;  // Front buffer does not match the terminal, repaint every cell
+    Pixel blank;       // Fill of cells a resize adds
+
+    ScreenLayout layout;       // Cell storage layout of both buffers
+    ScreenPlanes planes;       // Cell planes (Layout_Planar)
+    ScreenPlanes front_planes; // Last presented frame (Layout_Planar)
+    PackedCell *cells;         // Packed cells (Layout_Packed)
+    PackedCell *front_cells;   // Last presented frame (Layout_Packed)
+    ScreenStyles *styles;      // Style table of the packed cells
+    int stride;                // Plane row length in cells, padded to SCREEN_PLANE_ALIGN bytes
+    void *plane_memory;        // Arena block holding all planes or packed cells
+
+    ScreenSpan *dirty; // Per-row spans touched by drawing functions since the last present
+    int dirty_top;     // First row with a dirty span (dirty_top > dirty_bottom when clean)
+    int dirty_bottom;  // Last row with a dirty span
+
+    ScreenClip clips[SCREEN_CLIP_DEPTH]; // Pushed clip rectangles, the last one is active
+    int clip_depth;                      // Pushed entries (0 draws to the whole screen)
     
-    wchar_t *buffer;   // Render buffer for output
-    int buffer_size;   // Size of the render buffer
+    wchar_t *buffer;     // Render buffer for wide output
+    char *bytes;         // Render buffer for UTF-8 output
+    int buffer_size;     // Size of the active render buffer in elements
+    ScreenOutput output; // Output backend
+    bool sync_updates;   // Wrap frames in synchronized update (DEC mode 2026) and send them in one write
+    int encode_flags;    // EncodeFlags used by print_screen
+    ScreenEncoder *encoder; // Row-band worker pool (NULL encodes on the calling thread only)
+
+    bool headless;       // No terminal attached, output goes to 'sink'
+    bool layer;          // Render layer: no front buffer and no output, composited instead of printed
+    ScreenSink sink;     // Headless byte sink (NULL discards the output)
+    void *sink_context;  // Passed to 'sink' as the first argument
+    ScreenStats stats;   // Bytes per frame counters
+    ScreenRenderer *renderer; // Output thread, print_screen hands frames over when set
 
-    TerminalMode mode; // Terminal color mode
+    TerminalMode mode;   // Terminal color mode
+    SgrCache *sgr_cache; // Encoded attribute transitions
+    Arena *arena;        // Arena the screen buffers are allocated from
 };
 
 
@@ -84,8 +313,38 @@ struct Screen {
 
 // Screen management
 Screen *init_screen(Arena *arena, int width, int height, Color background, Color foreground, wchar_t symbol);
+Screen *init_screen_headless(Arena *arena, int width, int height, Color background, Color foreground, wchar_t symbol,
+                             ScreenSink sink, void *context);
 void    screen_shutdown(Screen *screen);
-void    print_screen(const Screen *screen);
+void    print_screen(Screen *screen);
+void    screen_force_redraw(Screen *screen);
+bool    screen_set_output(Screen *screen, ScreenOutput output);
+void    screen_set_sync_updates(Screen *screen, bool enabled);
+void    screen_set_encode_flags(Screen *screen, int flags);
+void    screen_set_layout(Screen *screen, ScreenLayout layout);
+bool    screen_set_encode_threads(Screen *screen, int threads);
+bool    screen_resize(Screen *screen, int width, int height);
+bool    screen_poll_resize(Screen *screen); // Follows the terminal size after SIGWINCH
+
+// Headless output
+void    screen_memory_sink(void *context, const char *data, size_t length); // ScreenSink for a ScreenMemorySink context
+void    screen_reset_stats(Screen *screen);
+
+// Render thread (opt-in, frames are encoded and written off the calling thread)
+bool    screen_start_render_thread(Screen *screen);
+void    screen_stop_render_thread(Screen *screen);
+void    screen_publish_frame(Screen *screen);
+unsigned long screen_dropped_frames(Screen *screen);
+
+// Render layers (transparent cell buffers, COLOR_NONE and L'\0' glyphs show the cells below)
+Screen *screen_create_layer(Screen *screen);
+void    screen_clear_layer(Screen *layer);
+void    screen_composite(Screen *screen, const Screen *layer);
+
+// Clipping (drawing functions clip against the active rectangle and draw relative to its origin)
+bool screen_push_clip(Screen *screen, int y, int x, int height, int width);
+bool screen_push_viewport(Screen *screen, int y, int x, int height, int width);
+void screen_pop_clip(Screen *screen);
 
 // Drawing functions
 void add_borders(Screen *screen, int y, int x, int height, int width, Color background, Color foreground, const wchar_t *borders);
@@ -96,6 +355,28 @@ void insert_text(Screen *screen, int y, int x, const char *text, Color foregroun
 void insert_wtext(Screen *screen, int y, int x, const wchar_t *text, Color foreground, Color background, TextEffect effect);
 void screen_draw_cursor(Screen *screen, Coords coords, CursorConfig config); // Assuming Coords and CursorConfig are defined in components.h
 
+// Cell access (works in every layout, screen coordinates, marks the cell dirty, colors are stored as given)
+Pixel screen_get_pixel(const Screen *screen, int y, int x);
+void  screen_set_pixel(Screen *screen, int y, int x, Pixel pixel);
+void  screen_set_symbol(Screen *screen, int y, int x, wchar_t symbol);
+void  screen_set_foreground(Screen *screen, int y, int x, Color foreground);
+void  screen_set_background(Screen *screen, int y, int x, Color background);
+uint32_t screen_intern_style(Screen *screen, Color foreground, Color background, TextEffect effect); // Layout_Packed
+
+// Frame diff and span fill kernels (SSE2/AVX2 with scalar fallback, process-wide selection)
+SimdLevel screen_set_simd(SimdLevel level);
+SimdLevel screen_get_simd(void);
+int  screen_find_change(const Screen *screen, int y, int start, int end);
+int  screen_find_change_reverse(const Screen *screen, int y, int start, int end);
+bool screen_row_changes(const Screen *screen, int y, int *first, int *last);
+void screen_fill_span(Screen *screen, int y, int x, int length, wchar_t symbol, Color background, Color foreground);
+
+// Dirty tracking (code writing to 'pixels' directly must mark what it touched)
+void screen_mark_dirty(Screen *screen, int y, int x, int height, int width);
+void screen_clear_dirty(Screen *screen);
+bool screen_is_dirty(const Screen *screen);
+bool screen_get_dirty_span(const Screen *screen, int y, int *start, int *end);
+
 // Terminal setup (non-canonical mode)
 void set_noncanonical_mode(void);
 void restore_terminal_settings(void);
@@ -0,0 +1,634 @@
+#ifndef CUSTOM_SCREEN
+/*
+ * Screen kernels
+ * Frame diff and span fill loops with SSE2/AVX2 versions and a scalar fallback, selected at runtime
+ */
+#include "../zen.h"
+#include <stddef.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SCREEN_KERNELS_X86
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// -----------------------------------------------------------------------------
+//  Kernel Table
+// -----------------------------------------------------------------------------
+/*
+ * Kernel set of one instruction set level
+ * Pixel kernels work on interleaved rows, plane kernels on 'count' cells starting at 'offset' of every plane,
+ * cell kernels on packed rows
+ */
+typedef struct ScreenKernels {
+    int  (*find_pixels)(const Pixel *back, const Pixel *front, int count);  // First difference, count if none
+    int  (*rfind_pixels)(const Pixel *back, const Pixel *front, int count); // Last difference, -1 if none
+    int  (*find_planes)(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count);
+    int  (*rfind_planes)(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count);
+    void (*fill_pixels)(Pixel *row, int count, Pixel pixel, bool foreground, bool background);
+    void (*fill_plane)(void *plane, int count, uint32_t value); // 4-byte plane (symbol or color)
+    int  (*find_cells)(const PackedCell *back, const PackedCell *front, int count);
+    int  (*rfind_cells)(const PackedCell *back, const PackedCell *front, int count);
+    void (*fill_cells)(PackedCell *row, int count, PackedCell cell);
+} ScreenKernels;
+
+
+// -----------------------------------------------------------------------------
+//  Scalar Kernels
+// -----------------------------------------------------------------------------
+/*
+ * Compare two pixels field by field (padding is ignored)
+ */
+static inline bool pixel_same(const Pixel *a, const Pixel *b) {
+    return a->symbol           == b->symbol           &&
+           a->foreground.color == b->foreground.color &&
+           a->background.color == b->background.color &&
+           a->effect           == b->effect;
+}
+
+/*
+ * Compare one cell of two plane sets
+ */
+static inline bool plane_cell_same(const ScreenPlanes *a, const ScreenPlanes *b, size_t i) {
+    return a->symbol[i]           == b->symbol[i]           &&
+           a->foreground[i].color == b->foreground[i].color &&
+           a->background[i].color == b->background[i].color &&
+           a->effect[i]           == b->effect[i];
+}
+
+static int find_pixels_scalar(const Pixel *back, const Pixel *front, int count) {
+    int i = 0;
+    while (i < count && pixel_same(&back[i], &front[i])) i++;
+    return i;
+}
+
+static int rfind_pixels_scalar(const Pixel *back, const Pixel *front, int count) {
+    int i = count - 1;
+    while (i >= 0 && pixel_same(&back[i], &front[i])) i--;
+    return i;
+}
+
+static int find_planes_scalar(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count) {
+    int i = 0;
+    while (i < count && plane_cell_same(back, front, offset + (size_t)i)) i++;
+    return i;
+}
+
+static int rfind_planes_scalar(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count) {
+    int i = count - 1;
+    while (i >= 0 && plane_cell_same(back, front, offset + (size_t)i)) i--;
+    return i;
+}
+
+static void fill_pixels_scalar(Pixel *row, int count, Pixel pixel, bool foreground, bool background) {
+    for (int i = 0; i < count; i++) {
+        row[i].symbol = pixel.symbol;
+        if (foreground) row[i].foreground = pixel.foreground;
+        if (background) row[i].background = pixel.background;
+    }
+}
+
+static void fill_plane_scalar(void *plane, int count, uint32_t value) {
+    char *out = (char *)plane;
+    for (int i = 0; i < count; i++) memcpy(out + (size_t)i * sizeof(uint32_t), &value, sizeof(uint32_t));
+}
+
+static int find_cells_scalar(const PackedCell *back, const PackedCell *front, int count) {
+    int i = 0;
+    while (i < count && back[i] == front[i]) i++;
+    return i;
+}
+
+static int rfind_cells_scalar(const PackedCell *back, const PackedCell *front, int count) {
+    int i = count - 1;
+    while (i >= 0 && back[i] == front[i]) i--;
+    return i;
+}
+
+static void fill_cells_scalar(PackedCell *row, int count, PackedCell cell) {
+    for (int i = 0; i < count; i++) row[i] = cell;
+}
+
+static const ScreenKernels kernels_scalar = {
+    find_pixels_scalar, rfind_pixels_scalar,
+    find_planes_scalar, rfind_planes_scalar,
+    fill_pixels_scalar, fill_plane_scalar,
+    find_cells_scalar, rfind_cells_scalar, fill_cells_scalar
+};
+
+
+#ifdef SCREEN_KERNELS_X86
+// -----------------------------------------------------------------------------
+//  SSE2 Kernels
+// -----------------------------------------------------------------------------
+/*
+ * Byte mask of the meaningful part of a Pixel
+ * Everything up to and including 'effect', the trailing struct padding is never compared
+ */
+static inline __m128i pixel_keep_mask(void) {
+    unsigned char keep[16];
+    for (size_t i = 0; i < 16; i++) keep[i] = (i <= offsetof(Pixel, effect)) ? 0xFF : 0x00;
+    return _mm_loadu_si128((const __m128i *)(const void *)keep);
+}
+
+/*
+ * Check if a pixel differs
+ */
+static inline bool pixel_differs_sse2(const Pixel *a, const Pixel *b, __m128i keep) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(const void *)a);
+    __m128i y = _mm_loadu_si128((const __m128i *)(const void *)b);
+    __m128i diff = _mm_and_si128(_mm_xor_si128(x, y), keep);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF;
+}
+
+/*
+ * Check if any of four pixels differs
+ */
+static inline bool pixels4_differ_sse2(const Pixel *a, const Pixel *b, __m128i keep) {
+    __m128i diff = _mm_setzero_si128();
+    for (int k = 0; k < 4; k++) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(const void *)&a[k]);
+        __m128i y = _mm_loadu_si128((const __m128i *)(const void *)&b[k]);
+        diff = _mm_or_si128(diff, _mm_xor_si128(x, y));
+    }
+    diff = _mm_and_si128(diff, keep);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF;
+}
+
+static int find_pixels_sse2(const Pixel *back, const Pixel *front, int count) {
+    __m128i keep = pixel_keep_mask();
+    int i = 0;
+    while (i + 4 <= count && !pixels4_differ_sse2(&back[i], &front[i], keep)) i += 4;
+    while (i < count && !pixel_differs_sse2(&back[i], &front[i], keep)) i++;
+    return i;
+}
+
+static int rfind_pixels_sse2(const Pixel *back, const Pixel *front, int count) {
+    __m128i keep = pixel_keep_mask();
+    int i = count;
+    while (i - 4 >= 0 && !pixels4_differ_sse2(&back[i - 4], &front[i - 4], keep)) i -= 4;
+    i--;
+    while (i >= 0 && !pixel_differs_sse2(&back[i], &front[i], keep)) i--;
+    return i;
+}
+
+/*
+ * Equality mask of four plane cells
+ * Returns a 4-bit mask, bit k set if cell offset + k is unchanged
+ */
+static inline int planes4_same_sse2(const ScreenPlanes *a, const ScreenPlanes *b, size_t offset) {
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(const void *)(a->symbol + offset)),
+                                 _mm_loadu_si128((const __m128i *)(const void *)(b->symbol + offset)));
+    eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(const void *)(a->foreground + offset)),
+                                           _mm_loadu_si128((const __m128i *)(const void *)(b->foreground + offset))));
+    eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(const void *)(a->background + offset)),
+                                           _mm_loadu_si128((const __m128i *)(const void *)(b->background + offset))));
+
+    // Widen the byte compare of the effect plane to one lane per cell
+    int32_t effect_a, effect_b;
+    memcpy(&effect_a, a->effect + offset, sizeof(effect_a));
+    memcpy(&effect_b, b->effect + offset, sizeof(effect_b));
+    __m128i effect_eq = _mm_cmpeq_epi8(_mm_cvtsi32_si128(effect_a), _mm_cvtsi32_si128(effect_b));
+    effect_eq = _mm_unpacklo_epi8(effect_eq, effect_eq);
+    effect_eq = _mm_unpacklo_epi16(effect_eq, effect_eq);
+
+    eq = _mm_and_si128(eq, effect_eq);
+    return _mm_movemask_ps(_mm_castsi128_ps(eq));
+}
+
+static int find_planes_sse2(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int same = planes4_same_sse2(back, front, offset + (size_t)i);
+        if (same != 0xF) return i + __builtin_ctz((unsigned)~same & 0xFu);
+    }
+    while (i < count && plane_cell_same(back, front, offset + (size_t)i)) i++;
+    return i;
+}
+
+static int rfind_planes_sse2(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count) {
+    int i = count;
+    for (; i - 4 >= 0; i -= 4) {
+        int same = planes4_same_sse2(back, front, offset + (size_t)(i - 4));
+        if (same != 0xF) return i - 4 + (31 - __builtin_clz((unsigned)~same & 0xFu));
+    }
+    i--;
+    while (i >= 0 && plane_cell_same(back, front, offset + (size_t)i)) i--;
+    return i;
+}
+
+/*
+ * Byte mask of the pixel fields written by a fill
+ */
+static inline __m128i pixel_fill_mask(bool foreground, bool background) {
+    unsigned char mask[16] = {0};
+    memset(mask + offsetof(Pixel, symbol), 0xFF, sizeof(wchar_t));
+    if (foreground) memset(mask + offsetof(Pixel, foreground), 0xFF, sizeof(Color));
+    if (background) memset(mask + offsetof(Pixel, background), 0xFF, sizeof(Color));
+    return _mm_loadu_si128((const __m128i *)(const void *)mask);
+}
+
+static void fill_pixels_sse2(Pixel *row, int count, Pixel pixel, bool foreground, bool background) {
+    __m128i mask = pixel_fill_mask(foreground, background);
+    __m128i value = _mm_and_si128(_mm_loadu_si128((const __m128i *)(const void *)&pixel), mask);
+    for (int i = 0; i < count; i++) {
+        __m128i *cell = (__m128i *)(void *)&row[i];
+        __m128i old = _mm_loadu_si128(cell);
+        _mm_storeu_si128(cell, _mm_or_si128(_mm_andnot_si128(mask, old), value));
+    }
+}
+
+static void fill_plane_sse2(void *plane, int count, uint32_t value) {
+    char *out = (char *)plane;
+    __m128i v = _mm_set1_epi32((int)value);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128((__m128i *)(void *)(out + (size_t)i * sizeof(uint32_t)), v);
+    for (; i < count; i++) memcpy(out + (size_t)i * sizeof(uint32_t), &value, sizeof(uint32_t));
+}
+
+/*
+ * Equality mask of two packed cells
+ * Returns a 2-bit mask, bit k set if cell k is unchanged (SSE2 has no 64-bit compare, both halves must match)
+ */
+static inline int cells2_same_sse2(const PackedCell *a, const PackedCell *b) {
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(const void *)a),
+                                 _mm_loadu_si128((const __m128i *)(const void *)b));
+    int lanes = _mm_movemask_ps(_mm_castsi128_ps(eq));
+    return ((lanes & 0x3) == 0x3) | (((lanes & 0xC) == 0xC) << 1);
+}
+
+static int find_cells_sse2(const PackedCell *back, const PackedCell *front, int count) {
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        int same = cells2_same_sse2(&back[i], &front[i]);
+        if (same != 0x3) return i + ((same & 0x1) ? 1 : 0);
+    }
+    while (i < count && back[i] == front[i]) i++;
+    return i;
+}
+
+static int rfind_cells_sse2(const PackedCell *back, const PackedCell *front, int count) {
+    int i = count;
+    for (; i - 2 >= 0; i -= 2) {
+        int same = cells2_same_sse2(&back[i - 2], &front[i - 2]);
+        if (same != 0x3) return i - 2 + ((same & 0x2) ? 0 : 1);
+    }
+    i--;
+    while (i >= 0 && back[i] == front[i]) i--;
+    return i;
+}
+
+static void fill_cells_sse2(PackedCell *row, int count, PackedCell cell) {
+    __m128i v = _mm_set1_epi64x((long long)cell);
+    int i = 0;
+    for (; i + 2 <= count; i += 2) _mm_storeu_si128((__m128i *)(void *)&row[i], v);
+    if (i < count) row[i] = cell;
+}
+
+static const ScreenKernels kernels_sse2 = {
+    find_pixels_sse2, rfind_pixels_sse2,
+    find_planes_sse2, rfind_planes_sse2,
+    fill_pixels_sse2, fill_plane_sse2,
+    find_cells_sse2, rfind_cells_sse2, fill_cells_sse2
+};
+
+
+// -----------------------------------------------------------------------------
+//  AVX2 Kernels
+// -----------------------------------------------------------------------------
+/*
+ * Check if any of four pixels differs (two 256-bit compares)
+ */
+TARGET_AVX2 static inline bool pixels4_differ_avx2(const Pixel *a, const Pixel *b, __m256i keep) {
+    __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(const void *)a),
+                                  _mm256_loadu_si256((const __m256i *)(const void *)b));
+    __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(const void *)(a + 2)),
+                                  _mm256_loadu_si256((const __m256i *)(const void *)(b + 2)));
+    __m256i diff = _mm256_and_si256(_mm256_or_si256(d0, d1), keep);
+    return !_mm256_testz_si256(diff, diff);
+}
+
+TARGET_AVX2 static int find_pixels_avx2(const Pixel *back, const Pixel *front, int count) {
+    __m128i keep128 = pixel_keep_mask();
+    __m256i keep = _mm256_broadcastsi128_si256(keep128);
+    int i = 0;
+    while (i + 4 <= count && !pixels4_differ_avx2(&back[i], &front[i], keep)) i += 4;
+    while (i < count && !pixel_differs_sse2(&back[i], &front[i], keep128)) i++;
+    return i;
+}
+
+TARGET_AVX2 static int rfind_pixels_avx2(const Pixel *back, const Pixel *front, int count) {
+    __m128i keep128 = pixel_keep_mask();
+    __m256i keep = _mm256_broadcastsi128_si256(keep128);
+    int i = count;
+    while (i - 4 >= 0 && !pixels4_differ_avx2(&back[i - 4], &front[i - 4], keep)) i -= 4;
+    i--;
+    while (i >= 0 && !pixel_differs_sse2(&back[i], &front[i], keep128)) i--;
+    return i;
+}
+
+/*
+ * Equality mask of eight plane cells
+ * Returns an 8-bit mask, bit k set if cell offset + k is unchanged
+ */
+TARGET_AVX2 static inline int planes8_same_avx2(const ScreenPlanes *a, const ScreenPlanes *b, size_t offset) {
+    __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(const void *)(a->symbol + offset)),
+                                    _mm256_loadu_si256((const __m256i *)(const void *)(b->symbol + offset)));
+    eq = _mm256_and_si256(eq, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(const void *)(a->foreground + offset)),
+                                                 _mm256_loadu_si256((const __m256i *)(const void *)(b->foreground + offset))));
+    eq = _mm256_and_si256(eq, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(const void *)(a->background + offset)),
+                                                 _mm256_loadu_si256((const __m256i *)(const void *)(b->background + offset))));
+
+    __m128i effect_eq = _mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i *)(const void *)(a->effect + offset)),
+                                       _mm_loadl_epi64((const __m128i *)(const void *)(b->effect + offset)));
+    eq = _mm256_and_si256(eq, _mm256_cvtepi8_epi32(effect_eq)); // 0xFF sign-extends to a full lane
+
+    return _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+}
+
+TARGET_AVX2 static int find_planes_avx2(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int same = planes8_same_avx2(back, front, offset + (size_t)i);
+        if (same != 0xFF) return i + __builtin_ctz((unsigned)~same & 0xFFu);
+    }
+    while (i < count && plane_cell_same(back, front, offset + (size_t)i)) i++;
+    return i;
+}
+
+TARGET_AVX2 static int rfind_planes_avx2(const ScreenPlanes *back, const ScreenPlanes *front, size_t offset, int count) {
+    int i = count;
+    for (; i - 8 >= 0; i -= 8) {
+        int same = planes8_same_avx2(back, front, offset + (size_t)(i - 8));
+        if (same != 0xFF) return i - 8 + (31 - __builtin_clz((unsigned)~same & 0xFFu));
+    }
+    i--;
+    while (i >= 0 && plane_cell_same(back, front, offset + (size_t)i)) i--;
+    return i;
+}
+
+TARGET_AVX2 static void fill_pixels_avx2(Pixel *row, int count, Pixel pixel, bool foreground, bool background) {
+    __m128i mask128 = pixel_fill_mask(foreground, background);
+    __m128i value128 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(const void *)&pixel), mask128);
+    __m256i mask = _mm256_broadcastsi128_si256(mask128);
+    __m256i value = _mm256_broadcastsi128_si256(value128);
+
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m256i *cells = (__m256i *)(void *)&row[i];
+        __m256i old = _mm256_loadu_si256(cells);
+        _mm256_storeu_si256(cells, _mm256_or_si256(_mm256_andnot_si256(mask, old), value));
+    }
+    if (i < count) {
+        __m128i *cell = (__m128i *)(void *)&row[i];
+        _mm_storeu_si128(cell, _mm_or_si128(_mm_andnot_si128(mask128, _mm_loadu_si128(cell)), value128));
+    }
+}
+
+TARGET_AVX2 static void fill_plane_avx2(void *plane, int count, uint32_t value) {
+    char *out = (char *)plane;
+    __m256i v = _mm256_set1_epi32((int)value);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) _mm256_storeu_si256((__m256i *)(void *)(out + (size_t)i * sizeof(uint32_t)), v);
+    for (; i < count; i++) memcpy(out + (size_t)i * sizeof(uint32_t), &value, sizeof(uint32_t));
+}
+
+/*
+ * Equality mask of four packed cells
+ * Returns a 4-bit mask, bit k set if cell k is unchanged
+ */
+TARGET_AVX2 static inline int cells4_same_avx2(const PackedCell *a, const PackedCell *b) {
+    __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(const void *)a),
+                                    _mm256_loadu_si256((const __m256i *)(const void *)b));
+    return _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+}
+
+TARGET_AVX2 static int find_cells_avx2(const PackedCell *back, const PackedCell *front, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int same = cells4_same_avx2(&back[i], &front[i]);
+        if (same != 0xF) return i + __builtin_ctz((unsigned)~same & 0xFu);
+    }
+    while (i < count && back[i] == front[i]) i++;
+    return i;
+}
+
+TARGET_AVX2 static int rfind_cells_avx2(const PackedCell *back, const PackedCell *front, int count) {
+    int i = count;
+    for (; i - 4 >= 0; i -= 4) {
+        int same = cells4_same_avx2(&back[i - 4], &front[i - 4]);
+        if (same != 0xF) return i - 4 + (31 - __builtin_clz((unsigned)~same & 0xFu));
+    }
+    i--;
+    while (i >= 0 && back[i] == front[i]) i--;
+    return i;
+}
+
+TARGET_AVX2 static void fill_cells_avx2(PackedCell *row, int count, PackedCell cell) {
+    __m256i v = _mm256_set1_epi64x((long long)cell);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) _mm256_storeu_si256((__m256i *)(void *)&row[i], v);
+    for (; i < count; i++) row[i] = cell;
+}
+
+static const ScreenKernels kernels_avx2 = {
+    find_pixels_avx2, rfind_pixels_avx2,
+    find_planes_avx2, rfind_planes_avx2,
+    fill_pixels_avx2, fill_plane_avx2,
+    find_cells_avx2, rfind_cells_avx2, fill_cells_avx2
+};
+#endif // SCREEN_KERNELS_X86
+
+
+// -----------------------------------------------------------------------------
+//  Dispatch
+// -----------------------------------------------------------------------------
+static const ScreenKernels *kernels = NULL;
+static SimdLevel kernel_level = Simd_Scalar;
+
+/*
+ * Best level supported by the CPU
+ * Vector pixel kernels assume the 16-byte Pixel layout, other layouts stay scalar
+ */
+static SimdLevel detect_simd(void) {
+#ifdef SCREEN_KERNELS_X86
+    if (sizeof(Pixel) != 16 || sizeof(wchar_t) != 4 || sizeof(Color) != 4) return Simd_Scalar;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Simd_AVX2;
+    return Simd_SSE2;
+#else
+    return Simd_Scalar;
+#endif
+}
+
+/*
+ * Selects the screen kernels.
+ * Process-wide, Simd_Auto picks the best level of the CPU and higher levels than supported are clamped.
+ * Returns the level in use.
+ */
+SimdLevel screen_set_simd(SimdLevel level) {
+    SimdLevel supported = detect_simd();
+    if (level == Simd_Auto || level > supported) level = supported;
+
+    kernels = &kernels_scalar;
+#ifdef SCREEN_KERNELS_X86
+    if (level == Simd_SSE2) kernels = &kernels_sse2;
+    if (level == Simd_AVX2) kernels = &kernels_avx2;
+#endif
+    kernel_level = level;
+    return level;
+}
+
+/*
+ * Returns the kernel level in use.
+ */
+SimdLevel screen_get_simd(void) {
+    if (!kernels) screen_set_simd(Simd_Auto);
+    return kernel_level;
+}
+
+static inline const ScreenKernels *get_kernels(void) {
+    if (!kernels) screen_set_simd(Simd_Auto);
+    return kernels;
+}
+
+
+// -----------------------------------------------------------------------------
+//  Frame Diff
+// -----------------------------------------------------------------------------
+/*
+ * Clips a column range to the screen
+ * Returns false if nothing is left
+ */
+static inline bool clip_columns(const Screen *screen, int y, int *start, int *end) {
+    if (y < 0 || y >= screen->height) return false;
+    if (*start < 0) *start = 0;
+    if (*end >= screen->width) *end = screen->width - 1;
+    return *start <= *end;
+}
+
+/*
+ * Find first changed cell
+ * Returns the first column in [start, end] that differs from the last presented frame, end + 1 if none
+ */
+int screen_find_change(const Screen *screen, int y, int start, int end) {
+    if (!screen) return end + 1;
+    int last = end;
+    if (!clip_columns(screen, y, &start, &end)) return last + 1;
+    if (screen->full_redraw) return start;
+
+    const ScreenKernels *k = get_kernels();
+    int count = end - start + 1;
+    int found;
+    if (screen->layout == Layout_Interleaved) {
+        size_t row = (size_t)y * (size_t)screen->width;
+        found = k->find_pixels(screen->pixels[y] + start, screen->front + row + start, count);
+    }
+    else if (screen->layout == Layout_Packed) {
+        size_t offset = (size_t)y * (size_t)screen->stride + (size_t)start;
+        found = k->find_cells(screen->cells + offset, screen->front_cells + offset, count);
+    }
+    else {
+        size_t offset = (size_t)y * (size_t)screen->stride + (size_t)start;
+        found = k->find_planes(&screen->planes, &screen->front_planes, offset, count);
+    }
+    return (found < count) ? start + found : last + 1;
+}
+
+/*
+ * Find last changed cell
+ * Returns the last column in [start, end] that differs from the last presented frame, start - 1 if none
+ */
+int screen_find_change_reverse(const Screen *screen, int y, int start, int end) {
+    if (!screen) return start - 1;
+    int first = start;
+    if (!clip_columns(screen, y, &start, &end)) return first - 1;
+    if (screen->full_redraw) return end;
+
+    const ScreenKernels *k = get_kernels();
+    int count = end - start + 1;
+    int found;
+    if (screen->layout == Layout_Interleaved) {
+        size_t row = (size_t)y * (size_t)screen->width;
+        found = k->rfind_pixels(screen->pixels[y] + start, screen->front + row + start, count);
+    }
+    else if (screen->layout == Layout_Packed) {
+        size_t offset = (size_t)y * (size_t)screen->stride + (size_t)start;
+        found = k->rfind_cells(screen->cells + offset, screen->front_cells + offset, count);
+    }
+    else {
+        size_t offset = (size_t)y * (size_t)screen->stride + (size_t)start;
+        found = k->rfind_planes(&screen->planes, &screen->front_planes, offset, count);
+    }
+    return (found >= 0) ? start + found : first - 1;
+}
+
+/*
+ * Get changed columns of a row
+ * Returns false if the row matches the last presented frame, otherwise stores the first and last changed column
+ */
+bool screen_row_changes(const Screen *screen, int y, int *first, int *last) {
+    if (!screen || y < 0 || y >= screen->height) return false;
+
+    int start = screen_find_change(screen, y, 0, screen->width - 1);
+    if (start >= screen->width) return false;
+    int end = screen_find_change_reverse(screen, y, start, screen->width - 1);
+
+    if (first) *first = start;
+    if (last)  *last  = end;
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+//  Span Fill
+// -----------------------------------------------------------------------------
+/*
+ * Fill span of a row
+ * Sets symbol and colors of 'length' cells starting at (y, x), COLOR_NONE keeps the current color
+ * and the effect is kept (fill_area semantics). Clips to the screen and marks the span dirty
+ */
+void screen_fill_span(Screen *screen, int y, int x, int length, wchar_t symbol, Color background, Color foreground) {
+    if (!screen || y < 0 || y >= screen->height || length <= 0) return;
+    if (x < 0) {
+        length += x;
+        x = 0;
+    }
+    if (x + length > screen->width) length = screen->width - x;
+    if (length <= 0) return;
+
+    const ScreenKernels *k = get_kernels();
+    bool set_foreground = !is_none(foreground);
+    bool set_background = !is_none(background);
+
+    if (screen->layout == Layout_Interleaved) {
+        Pixel pixel = (Pixel) {background, foreground, symbol, Effect_None};
+        k->fill_pixels(screen->pixels[y] + x, length, pixel, set_foreground, set_background);
+    }
+    else if (screen->layout == Layout_Packed) {
+        // Restyle per run of equal styles, a run becomes one vector fill
+        PackedCell *row = screen->cells + (size_t)y * (size_t)screen->stride + (size_t)x;
+        int i = 0;
+        while (i < length) {
+            uint32_t old = PACKED_STYLE(row[i]);
+            int run = 1;
+            while (i + run < length && PACKED_STYLE(row[i + run]) == old) run++;
+
+            ScreenStyle style = screen->styles->entries[old];
+            if (set_foreground) style.foreground = foreground;
+            if (set_background) style.background = background;
+            uint32_t id = screen_intern_style(screen, style.foreground, style.background, style.effect);
+            if (id != SCREEN_STYLE_NONE) k->fill_cells(row + i, run, PACKED_CELL(symbol, id));
+            i += run;
+        }
+    }
+    else {
+        size_t offset = (size_t)y * (size_t)screen->stride + (size_t)x;
+        k->fill_plane(screen->planes.symbol + offset, length, (uint32_t)symbol);
+        if (set_foreground) k->fill_plane(screen->planes.foreground + offset, length, foreground.color);
+        if (set_background) k->fill_plane(screen->planes.background + offset, length, background.color);
+    }
+    screen_mark_dirty(screen, y, x, 1, length);
+}
+
+#endif // CUSTOM_SCREEN
@@ -0,0 +1,276 @@
+#ifndef CUSTOM_SCREEN
+/*
+ * Screen render thread
+ * Triple-buffered frame handoff from the drawing thread to a dedicated output thread
+ */
+#include "../zen.h"
+#include <pthread.h>
+
+#define RENDER_FRAMES 3 // Drawing, latest completed and presenting frame
+
+// -----------------------------------------------------------------------------
+//  Render Thread State
+// -----------------------------------------------------------------------------
+/*
+ * Frame snapshot
+ * Cells and encoder settings of one published frame
+ */
+typedef struct ScreenFrame {
+    Pixel *pixels;          // width * height cells, row-major
+    bool full_redraw;       // Repaint every cell
+    TerminalMode mode;      // Color mode of the frame
+    ScreenOutput output;    // Output backend of the frame
+    int encode_flags;       // Encoder options of the frame
+    bool sync_updates;      // Synchronized update of the frame
+} ScreenFrame;
+
+/*
+ * Render thread state
+ * The drawing thread owns frames[write], the output thread frames[read], frames[ready] is the
+ * latest completed frame. Indices only change under 'lock'
+ */
+struct ScreenRenderer {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+
+    Arena *arena;       // Private arena, the output thread never touches the screen arena
+    Screen *output;     // Encoder state of the output thread (front buffer, render buffer)
+    ScreenFrame frames[RENDER_FRAMES];
+    int write;          // Frame being drawn
+    int ready;          // Latest completed frame
+    int read;           // Frame being presented
+    bool fresh;         // frames[ready] has not been presented yet
+    bool running;       // Cleared to stop the thread
+    unsigned long dropped; // Frames replaced before the output thread took them
+    ScreenStats presented; // Frames presented since the drawing thread last collected them
+};
+
+
+/*
+ * Adds the counters of presented frames to 'stats'
+ * Per-frame values come from the last presented frame and are kept when none was presented,
+ * so a terminal that is still busy keeps reporting its last write time
+ */
+static void merge_stats(ScreenStats *stats, const ScreenStats *presented) {
+    if (!presented->frames) return;
+    stats->frames += presented->frames;
+    stats->total_bytes += presented->total_bytes;
+    stats->last_frame_bytes = presented->last_frame_bytes;
+    if (presented->peak_frame_bytes > stats->peak_frame_bytes) stats->peak_frame_bytes = presented->peak_frame_bytes;
+    stats->last_write_ns = presented->last_write_ns;
+    stats->queued_bytes = presented->queued_bytes;
+}
+
+
+// -----------------------------------------------------------------------------
+//  Output Thread
+// -----------------------------------------------------------------------------
+/*
+ * Presents a frame
+ * Loads the snapshot into the output screen and encodes the difference to the last presented frame
+ */
+static void present_frame(ScreenRenderer *renderer, const ScreenFrame *frame) {
+    Screen *output = renderer->output;
+    if (frame->output != output->output) screen_set_output(output, frame->output);
+    output->mode = frame->mode;
+    output->encode_flags = frame->encode_flags;
+    output->sync_updates = frame->sync_updates;
+    if (frame->full_redraw) output->full_redraw = true;
+
+    // Frames in between may have been dropped, so the whole frame is diffed
+    size_t row = (size_t)output->width * sizeof(Pixel);
+    for (int y = 0; y < output->height; y++) {
+        memcpy(output->pixels[y], frame->pixels + (size_t)y * (size_t)output->width, row);
+    }
+    screen_mark_dirty(output, 0, 0, output->height, output->width);
+    print_screen(output);
+}
+
+/*
+ * Output thread
+ * Sleeps until a frame is published, always presents the latest one. Drains the pending frame before exiting
+ */
+static void *render_thread(void *arg) {
+    ScreenRenderer *renderer = (ScreenRenderer *)arg;
+
+    pthread_mutex_lock(&renderer->lock);
+    for (;;) {
+        while (renderer->running && !renderer->fresh) pthread_cond_wait(&renderer->wake, &renderer->lock);
+        if (!renderer->fresh) break;
+
+        int frame = renderer->ready;
+        renderer->ready = renderer->read;
+        renderer->read = frame;
+        renderer->fresh = false;
+        pthread_mutex_unlock(&renderer->lock);
+
+        present_frame(renderer, &renderer->frames[frame]);
+
+        const ScreenStats *output = &renderer->output->stats;
+        ScreenStats presented = {
+            .frames = 1,
+            .last_frame_bytes = output->last_frame_bytes,
+            .peak_frame_bytes = output->last_frame_bytes,
+            .total_bytes = output->last_frame_bytes,
+            .last_write_ns = output->last_write_ns,
+            .queued_bytes = output->queued_bytes
+        };
+        pthread_mutex_lock(&renderer->lock);
+        merge_stats(&renderer->presented, &presented);
+    }
+    pthread_mutex_unlock(&renderer->lock);
+    return NULL;
+}
+
+
+// -----------------------------------------------------------------------------
+//  Frame Handoff
+// -----------------------------------------------------------------------------
+/*
+ * Starts the render thread.
+ * From now on print_screen only snapshots the frame, encoding and terminal writes happen on a
+ * dedicated thread that always presents the latest completed frame. Returns false if the thread
+ * could not be started, the screen then keeps rendering synchronously.
+ */
+bool screen_start_render_thread(Screen *screen) {
+    if (!screen) return false;
+    if (screen->renderer) return true;
+
+    size_t cells = (size_t)screen->width * (size_t)screen->height;
+    Arena *arena = arena_new_dynamic((ssize_t)(cells * sizeof(Pixel) * 8 + 64 * 1024));
+    if (!arena) return false;
+
+    ScreenRenderer *renderer = (ScreenRenderer *)arena_alloc(arena, sizeof(ScreenRenderer));
+    if (!renderer) {
+        arena_free(arena);
+        return false;
+    }
+    memset(renderer, 0, sizeof(ScreenRenderer));
+    renderer->arena = arena;
+
+    // The output screen shares the destination of the screen, but never its buffers
+    Screen *output = init_screen_headless(arena, screen->width, screen->height, COLOR_NONE, COLOR_NONE, L' ',
+                                          screen->sink, screen->sink_context);
+    if (!output) {
+        arena_free(arena);
+        return false;
+    }
+    output->headless = screen->headless;
+    if (output->output != screen->output && !screen_set_output(output, screen->output)) {
+        arena_free(arena);
+        return false;
+    }
+    renderer->output = output;
+
+    for (int i = 0; i < RENDER_FRAMES; i++) {
+        renderer->frames[i].pixels = (Pixel *)arena_alloc(arena, cells * sizeof(Pixel));
+        if (!renderer->frames[i].pixels) {
+            arena_free(arena);
+            return false;
+        }
+    }
+    renderer->write = 0;
+    renderer->ready = 1;
+    renderer->read = 2;
+    renderer->running = true;
+
+    screen_get_simd(); // Select the kernels before a second thread can race on it
+    pthread_mutex_init(&renderer->lock, NULL);
+    pthread_cond_init(&renderer->wake, NULL);
+    if (pthread_create(&renderer->thread, NULL, render_thread, renderer) != 0) {
+        pthread_cond_destroy(&renderer->wake);
+        pthread_mutex_destroy(&renderer->lock);
+        arena_free(arena);
+        return false;
+    }
+
+    screen->renderer = renderer;
+    screen->full_redraw = true; // The output thread starts without a front buffer
+    return true;
+}
+
+/*
+ * Stops the render thread.
+ * Waits until the last published frame is written, print_screen renders synchronously again.
+ */
+void screen_stop_render_thread(Screen *screen) {
+    if (!screen || !screen->renderer) return;
+    ScreenRenderer *renderer = screen->renderer;
+
+    pthread_mutex_lock(&renderer->lock);
+    renderer->running = false;
+    pthread_cond_signal(&renderer->wake);
+    pthread_mutex_unlock(&renderer->lock);
+    pthread_join(renderer->thread, NULL);
+    merge_stats(&screen->stats, &renderer->presented); // Frames drained on exit
+
+    pthread_cond_destroy(&renderer->wake);
+    pthread_mutex_destroy(&renderer->lock);
+    arena_free(renderer->arena);
+
+    screen->renderer = NULL;
+    screen->full_redraw = true; // The terminal shows what the output thread presented last
+}
+
+/*
+ * Publishes the current frame.
+ * Copies the cells into the drawing frame and hands it to the output thread, replacing a completed
+ * frame the thread has not taken yet. Never waits for terminal I/O. Called by print_screen.
+ * Collects the stats of the frames presented since the last call into the screen stats.
+ */
+void screen_publish_frame(Screen *screen) {
+    if (!screen || !screen->renderer) return;
+    ScreenRenderer *renderer = screen->renderer;
+    ScreenFrame *frame = &renderer->frames[renderer->write];
+
+    if (screen->layout == Layout_Interleaved) {
+        size_t row = (size_t)screen->width * sizeof(Pixel);
+        for (int y = 0; y < screen->height; y++) {
+            memcpy(frame->pixels + (size_t)y * (size_t)screen->width, screen->pixels[y], row);
+        }
+    }
+    else {
+        Pixel *out = frame->pixels;
+        for (int y = 0; y < screen->height; y++) {
+            for (int x = 0; x < screen->width; x++) *out++ = screen_get_pixel(screen, y, x);
+        }
+    }
+    frame->full_redraw = screen->full_redraw;
+    frame->mode = screen->mode;
+    frame->output = screen->output;
+    frame->encode_flags = screen->encode_flags;
+    frame->sync_updates = screen->sync_updates;
+
+    pthread_mutex_lock(&renderer->lock);
+    if (renderer->fresh) {
+        // The replaced frame is never presented, its repaint request carries over
+        renderer->dropped++;
+        frame->full_redraw |= renderer->frames[renderer->ready].full_redraw;
+    }
+    int ready = renderer->ready;
+    renderer->ready = renderer->write;
+    renderer->write = ready;
+    renderer->fresh = true;
+    merge_stats(&screen->stats, &renderer->presented);
+    memset(&renderer->presented, 0, sizeof(ScreenStats));
+    pthread_cond_signal(&renderer->wake);
+    pthread_mutex_unlock(&renderer->lock);
+
+    screen->full_redraw = false;
+    screen_clear_dirty(screen);
+}
+
+/*
+ * Returns the number of frames replaced before the render thread presented them.
+ */
+unsigned long screen_dropped_frames(Screen *screen) {
+    if (!screen || !screen->renderer) return 0;
+
+    pthread_mutex_lock(&screen->renderer->lock);
+    unsigned long dropped = screen->renderer->dropped;
+    pthread_mutex_unlock(&screen->renderer->lock);
+    return dropped;
+}
+
+#endif // CUSTOM_SCREEN
@@ -13,7 +13,12 @@ FpsStats *create_fps_stats(Arena *arena) {
         .avg_fps = 0,
         .max_fps = 0,
         .min_fps = 0,
-        .frame_count = 0
+        .frame_count = 0,
+        .pace_fps = 0,
+        .throttled_frames = 0,
+        .skipped_frames = 0,
+        .write_time = 0,
+        .queued_bytes = 0
     };
 
     return stats;
@@ -66,8 +71,16 @@ void draw_fps_stats(const FpsStats *stats, Screen *screen) {
 
 
 
-    int result_len = snprintf(fps_buffer, sizeof(fps_buffer), "FPS:%.2f (min: %.2f, avg:%.2f)",
+    int result_len;
+    if (stats->pace_fps > 0) {
+        // Adaptive pacing is on, show the pace it settled on
+        result_len = snprintf(fps_buffer, sizeof(fps_buffer), "FPS:%.2f (min: %.2f, avg:%.2f) pace:%.1f skip:%d",
+                              stats->cur_fps, stats->min_fps, stats->avg_fps, stats->pace_fps, stats->skipped_frames);
+    }
+    else {
+        result_len = snprintf(fps_buffer, sizeof(fps_buffer), "FPS:%.2f (min: %.2f, avg:%.2f)",
                               stats->cur_fps, stats->min_fps, stats->avg_fps);
+    }
     if (screen->width >= result_len) {
         insert_text(screen, 0, 0, fps_buffer, COLOR_WHITE, COLOR_BLACK, Effect_Bold);
     }
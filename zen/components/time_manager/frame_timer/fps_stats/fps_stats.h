@@ -14,6 +14,12 @@ typedef struct FpsStats {
     double cur_fps;        // Current frame rate
     int frame_count;       // Number of frames recorded
     bool draw_to_screen;   // Flag to indicate if FPS should be drawn on screen
+
+    double pace_fps;       // Frame rate limit chosen by adaptive pacing (0 if unlimited or disabled)
+    int throttled_frames;  // Frames after which pacing backed off
+    int skipped_frames;    // Due frames dropped because the terminal was far behind
+    double write_time;     // Seconds the last frame spent writing
+    size_t queued_bytes;   // Bytes still queued for the terminal after the last frame
 } FpsStats;
 
 FpsStats *create_fps_stats(Arena *arena);
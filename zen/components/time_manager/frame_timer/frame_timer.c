@@ -1,4 +1,3 @@
-
 #include "zen.h"
 
 /*
@@ -20,16 +19,35 @@ FrameTimer init_frame_timer(void) {
  */
 void set_target_fps(FrameTimer *timer, int fps) {
     timer->target_frame_time = 1.0 / fps;
+    if (timer->pace_frame_time < timer->target_frame_time) timer->pace_frame_time = timer->target_frame_time;
+}
+
+/*
+ * Set adaptive pacing
+ * Lowers the frame rate while the terminal falls behind and recovers once it keeps up again
+ */
+void set_adaptive_pacing(FrameTimer *timer, bool enabled) {
+    timer->adaptive = enabled;
+    timer->pace_frame_time = timer->target_frame_time;
+    timer->skip_next = false;
+    if (timer->stats) timer->stats->pace_fps = 0;
 }
 
 bool should_render_frame(FrameTimer *timer, TimeManager *tm) {
     double elapsed = (double)(tm->current_time.tv_sec - timer->frame_start.tv_sec) +
                      (double)(tm->current_time.tv_nsec - timer->frame_start.tv_nsec) / 1e9;
 
-    if (elapsed < timer->target_frame_time) return false;
+    double frame_time = timer->adaptive ? timer->pace_frame_time : timer->target_frame_time;
+    if (elapsed < frame_time) return false;
 
     timer->frame_start = tm->current_time;
 
+    if (timer->skip_next) {
+        timer->skip_next = false;
+        if (timer->stats) timer->stats->skipped_frames++;
+        return false;
+    }
+
     if (timer->stats) {
         double current_fps = 1.0 / elapsed;
         update_fps_stats(timer->stats, current_fps);
@@ -37,3 +55,36 @@ bool should_render_frame(FrameTimer *timer, TimeManager *tm) {
 
     return true;
 }
+
+/*
+ * Update frame pacing
+ * Feeds the output cost of the last frame into adaptive pacing. The terminal is behind when a write
+ * blocked or more than a frame is still queued: the frame time backs off, and the next frame is
+ * skipped if even two frames are queued. Otherwise the frame time decays back to the target
+ */
+void update_frame_pacing(FrameTimer *timer, double write_time, size_t frame_bytes, size_t queued_bytes) {
+    if (!timer->adaptive) return;
+
+    bool behind = write_time > PACING_BLOCKED_WRITE || (frame_bytes && queued_bytes > frame_bytes);
+    if (behind) {
+        double base = (timer->pace_frame_time > PACING_MIN_FRAME_TIME) ? timer->pace_frame_time : PACING_MIN_FRAME_TIME;
+        timer->pace_frame_time = base * PACING_BACKOFF;
+        if (timer->pace_frame_time > PACING_MAX_FRAME_TIME) timer->pace_frame_time = PACING_MAX_FRAME_TIME;
+        timer->skip_next = frame_bytes && queued_bytes > 2 * frame_bytes;
+    }
+    else {
+        timer->skip_next = false;
+        timer->pace_frame_time *= PACING_RECOVERY;
+        if (timer->pace_frame_time < timer->target_frame_time || timer->pace_frame_time < PACING_MIN_FRAME_TIME) {
+            timer->pace_frame_time = timer->target_frame_time;
+        }
+    }
+
+    if (timer->stats) {
+        FpsStats *stats = timer->stats;
+        if (behind) stats->throttled_frames++;
+        stats->pace_fps = (timer->pace_frame_time > 0) ? 1.0 / timer->pace_frame_time : 0;
+        stats->write_time = write_time;
+        stats->queued_bytes = queued_bytes;
+    }
+}
@@ -4,6 +4,12 @@
 #include "../time_manager.h"
 #include "fps_stats/fps_stats.h"
 
+#define PACING_MIN_FRAME_TIME (1.0 / 240) // Frame time adaptive pacing backs off from when uncapped
+#define PACING_MAX_FRAME_TIME 0.25        // Slowest adaptive pace (4 FPS)
+#define PACING_BLOCKED_WRITE  0.002       // A write taking longer only waited for a full terminal queue
+#define PACING_BACKOFF        1.5         // Frame time growth while the terminal falls behind
+#define PACING_RECOVERY       0.8         // Frame time decay while the terminal keeps up
+
 /*
  * Frame timer structure
  * Measures frame start and end times to regulate FPS.
@@ -13,10 +19,16 @@ typedef struct FrameTimer {
     struct timespec frame_end;     // Timestamp of frame end
     double target_frame_time;      // Desired time per frame (for FPS control)
     FpsStats *stats;               // Pointer to FPS statistics
+
+    bool adaptive;                 // Pace frames by terminal backpressure
+    double pace_frame_time;        // Effective time per frame chosen by adaptive pacing
+    bool skip_next;                // Drop the next due frame, the terminal is far behind
 } FrameTimer;
 
 FrameTimer init_frame_timer(void);
 void set_target_fps(FrameTimer *timer, int fps);
+void set_adaptive_pacing(FrameTimer *timer, bool enabled);
 bool should_render_frame(FrameTimer *timer, TimeManager *tm);
+void update_frame_pacing(FrameTimer *timer, double write_time, size_t frame_bytes, size_t queued_bytes);
 
 #endif
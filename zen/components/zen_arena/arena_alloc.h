@@ -50,6 +50,8 @@
 // */
 // Arena *arena_new_dynamic(size_t size);
 // Arena *arena_new_static(void *memory, size_t size);
+// Arena *arena_new_growable(ssize_t size, ssize_t limit);
+// bool arena_make_shared(Arena *arena);
 // void arena_reset(Arena *arena);
 // void *arena_alloc(Arena *arena, size_t size);
 // void arena_free_block(void *data);
@@ -63,7 +65,9 @@
 #ifndef ARENA_ALLOCATOR_H
 #define ARENA_ALLOCATOR_H
 
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <sys/types.h>  // for ssize_t
 
@@ -72,6 +76,19 @@
     #define MIN_BUFFER_SIZE 16
 #endif
 
+// Alignment of every block returned by arena_alloc (sizes are rounded up to it)
+#define ARENA_ALIGNMENT 16
+#define ARENA_ALIGN_UP(size, align) (((size) + (align) - 1) & ~((size_t)(align) - 1))
+#define ARENA_MAX_REQUEST (SIZE_MAX - (ARENA_ALIGNMENT - 1)) // Largest size ARENA_ALIGN_UP rounds without wrapping
+
+// Size-class bins for small blocks: one bin per multiple of ARENA_ALIGNMENT up to ARENA_BIN_MAX
+#define ARENA_BIN_COUNT 16
+#define ARENA_BIN_MAX (ARENA_BIN_COUNT * ARENA_ALIGNMENT)
+#define arena_bin_index(size) ((size) / ARENA_ALIGNMENT - 1)
+
+// Blocks per size class a thread cache holds, refills and flushes move half of it at once
+#define ARENA_MAGAZINE_SIZE 32
+
 #define RED false
 #define BLACK true
 
@@ -80,6 +97,8 @@
 // Structure type declarations for memory management.
 typedef struct Block Block;
 typedef struct Arena Arena;
+typedef struct Scratch Scratch;
+typedef struct ArenaCache ArenaCache;
 
 /*
  * Union for block flags
@@ -89,7 +108,8 @@ typedef union BlockFlags {
     struct {
         bool is_free     : 1;    // Flag indicating whether the block is free.
         bool color       : 1;    // Color for RB tree: 0 = RED, 1 = BLACK
-        unsigned padding : 6;    // Padding to make the union size 8 bytes
+        bool is_binned   : 1;    // Flag indicating whether the block waits in a size-class bin.
+        unsigned padding : 5;    // Padding to make the union size 8 bytes
     } bits;
     char raw;                    // Raw byte value, used for comparison as a magic number
 } BlockFlags;
@@ -107,10 +127,13 @@ struct Block {
 
     BlockFlags flags;
     
-    Block *left_free;     // Left child in red-black tree
+    Block *left_free;     // Left child in red-black tree (next block of a size-class bin)
     Block *right_free;    // Right child in red-black tree
 };
 
+// Block headers keep the data behind them aligned
+_Static_assert(sizeof(Block) % ARENA_ALIGNMENT == 0, "Block header size must be a multiple of ARENA_ALIGNMENT");
+
 /*
  * Memory arena structure.
  * Manages a pool of memory, block allocation, and block states.
@@ -125,15 +148,64 @@ struct Arena {
     Block *free_blocks;                  // Pointer to the list of free blocks (становится корнем RB-дерева).
 
     size_t free_size_in_tail;            // Free space available in the tail block.
+
+    bool is_growable;                    // Flag indicating if the arena chains new regions when full.
+    size_t limit;                        // Total size of all regions of a growable arena (0 = no limit).
+    Arena *next;                         // Next region of a growable arena.
+
+    bool use_bins;                       // Flag indicating if small freed blocks go to the size-class bins.
+    Block *bins[ARENA_BIN_COUNT];        // Freed blocks of 16..ARENA_BIN_MAX bytes, one LIFO list per size.
+
+    Arena *head;                         // First region of the chain, owns the lock.
+    bool is_shared;                      // Flag indicating if every operation takes the lock of the head (set in every region).
+    pthread_mutex_t lock;                // Lock of a shared arena.
+};
+
+/*
+ * Thread cache structure.
+ * Magazines of small blocks owned by one thread, only refills and flushes lock the shared arena.
+ * Cached blocks stay marked as used, their headers are never written without the lock.
+ * The cache lives in its arena, arena_reset invalidates it (destroy caches before a reset).
+ */
+struct ArenaCache {
+    Arena *arena;                                        // Arena the blocks come from.
+    int counts[ARENA_BIN_COUNT];                         // Blocks held per size class.
+    Block *magazines[ARENA_BIN_COUNT][ARENA_MAGAZINE_SIZE];
+};
+
+/*
+ * Scratch arena structure.
+ * Bump-only region for short-lived data, every allocation is released at once by scratch_reset.
+ */
+struct Scratch {
+    char *data;                          // Start of the region, allocated from 'arena'.
+    size_t capacity;                     // Size of the region.
+    size_t used;                         // Bytes handed out since the last reset.
+    size_t high_water;                   // Largest 'used' seen, including requests that did not fit.
+    Arena *arena;                        // Arena the region is allocated from.
 };
 
 
 Arena *arena_new_dynamic(ssize_t size);
 Arena *arena_new_static(void *memory, ssize_t size);
+Arena *arena_new_growable(ssize_t size, ssize_t limit);
 void arena_reset(Arena *arena);
 void *arena_alloc(Arena *arena, size_t size);
+void *arena_alloc_aligned(Arena *arena, size_t size, size_t align);
 void arena_free_block(void *data);
 void arena_free(Arena *arena);
+bool arena_make_shared(Arena *arena);
+
+ArenaCache *arena_cache_new(Arena *arena);
+void *arena_cache_alloc(ArenaCache *cache, size_t size);
+void arena_cache_free(ArenaCache *cache, void *data);
+void arena_cache_flush(ArenaCache *cache);
+void arena_cache_destroy(ArenaCache *cache);
+
+Scratch *scratch_new(Arena *arena, size_t capacity);
+void *scratch_alloc(Scratch *scratch, size_t size);
+void scratch_reset(Scratch *scratch);
+void scratch_free(Scratch *scratch);
 
 #ifdef DEBUG
 #include <stdio.h>
@@ -145,6 +217,18 @@ void print_llrb_tree(Block *node, int depth);
 
 
 #ifdef ARENA_IMPLEMENTATION
+/*
+ * Lock a shared arena
+ * Takes the lock of the first region for any region of the arena, plain arenas are not locked
+ */
+static inline void lock_arena(Arena *arena) {
+    if (arena->is_shared) pthread_mutex_lock(&arena->head->lock);
+}
+
+static inline void unlock_arena(Arena *arena) {
+    if (arena->is_shared) pthread_mutex_unlock(&arena->head->lock);
+}
+
 /*
  * Safe next block pointer
  * Checks if the next block exists and is not in the tail free space
@@ -372,6 +456,7 @@ static inline Block *create_empty_block(Arena *arena, Block *prev_block) {
     // create new block
     Block *block = (Block *)new_chunk;
     block->size = 0;
+    block->flags.raw = 0; // Padding bits are the magic number of arena_free_block
     block->flags.bits.is_free = true;
     block->prev = NULL;
     block->flags.bits.color = RED;
@@ -413,6 +498,28 @@ static void *alloc_in_tail(Arena *arena, size_t size) {
     return block_data(block);
 }
 
+/*
+ * Split a block
+ * Shrinks the block to the given size and returns the rest to the free blocks, if it is large enough
+ */
+static void split_block(Arena *arena, Block *block, size_t size) {
+    if (block->size < size + sizeof(Block) + MIN_BUFFER_SIZE) return;
+
+    Block *block_after = next_block(arena, block);
+    size_t new_block_size = block->size - size - sizeof(Block);
+    block->size = size;
+
+    Block *new_block = create_empty_block(arena, block);
+    new_block->size = new_block_size;
+    new_block->flags.bits.is_free = true;
+
+    if (block_after) {
+        block_after->prev = new_block;
+    }
+    new_block->prev = block;
+    arena->free_blocks = insert(arena->free_blocks, new_block);
+}
+
 /*
  * Allocate memory from the free blocks
  * Updates the free blocks list and creates a new block if there is enough space
@@ -423,23 +530,7 @@ static void *alloc_in_free_blocks(Arena *arena, size_t size) {
     if (best) {
         detach(&arena->free_blocks, best);
         best->flags.bits.is_free = false;
-        if (best->size >= size + sizeof(Block) + MIN_BUFFER_SIZE) {
-            Block *block_after = next_block(arena, best);
-            size_t new_block_size = best->size - size - sizeof(Block);
-            best->size = size;
-            best->flags.bits.is_free = false;
-
-            Block *new_block = create_empty_block(arena, best);
-            new_block->size = new_block_size;
-            new_block->flags.bits.is_free = true;
-
-            if (block_after) {
-                block_after->prev = new_block;
-            }
-            new_block->prev = best;
-            arena->free_blocks = insert(arena->free_blocks, new_block);
-        }
-        
+        split_block(arena, best, size);
         return block_data(best);
     }
 
@@ -447,12 +538,66 @@ static void *alloc_in_free_blocks(Arena *arena, size_t size) {
 }
 
 /*
- * Allocate memory in the arena
+ * Pop a block from a size-class bin
+ * The block is still marked as used, it only leaves the bin
+ */
+static inline void *pop_bin(Arena *arena, size_t size) {
+    Block **bin = &arena->bins[arena_bin_index(size)];
+    Block *block = *bin;
+    *bin = block->left_free;
+
+    block->left_free = NULL;
+    block->flags.bits.is_binned = false;
+    return block_data(block);
+}
+
+/*
+ * Push a block to its size-class bin
+ * The block stays marked as used, so neighbours never merge with it until the bins are flushed
+ */
+static inline void push_bin(Arena *arena, Block *block) {
+    Block **bin = &arena->bins[arena_bin_index(block->size)];
+    block->flags.bits.is_binned = true;
+    block->left_free = *bin;
+    *bin = block;
+}
+
+static void arena_free_block_full(Arena *arena, void *data);
+
+/*
+ * Flush the size-class bins
+ * Frees every binned block for real, so they merge with their neighbours and the tail again
+ * Returns true if any block was flushed
+ */
+static bool flush_bins(Arena *arena) {
+    bool flushed = false;
+    for (int i = 0; i < ARENA_BIN_COUNT; i++) {
+        Block *block = arena->bins[i];
+        arena->bins[i] = NULL;
+
+        while (block) {
+            Block *next = block->left_free;
+            arena_free_block_full(arena, block_data(block));
+            block = next;
+            flushed = true;
+        }
+    }
+    return flushed;
+}
+
+/*
+ * Allocate memory in one region
  * Tries to allocate memory in the tail or from free blocks
  * Returns NULL if there is not enough space
  */
-void *arena_alloc(Arena *arena, size_t size) {
-    if (size == 0 || arena == NULL || size > arena->capacity) return NULL;
+static void *alloc_in_region(Arena *arena, size_t size) {
+    if (size > arena->capacity) return NULL;
+
+    // small sizes are served from their bin in O(1)
+    if (size <= ARENA_BIN_MAX && arena->bins[arena_bin_index(size)]) {
+        return pop_bin(arena, size);
+    }
+
     // check if there is enough space in the free blocks
     void *result = alloc_in_free_blocks(arena, size);
     if (result) return result;
@@ -465,6 +610,77 @@ void *arena_alloc(Arena *arena, size_t size) {
     return NULL;
 }
 
+/*
+ * Grow an arena
+ * Chains a new region at least twice as large as the last one and large enough for 'needed'
+ * bytes of blocks. Returns NULL if the arena is not growable, the limit is reached or malloc fails
+ */
+static Arena *grow_arena(Arena *arena, size_t needed) {
+    if (!arena->is_growable) return NULL;
+    if (needed > SIZE_MAX - (sizeof(Arena) + sizeof(Block) + MIN_BUFFER_SIZE + ARENA_ALIGNMENT)) return NULL;
+
+    Arena *last = arena;
+    size_t total = arena->capacity + sizeof(Arena);
+    while (last->next) {
+        last = last->next;
+        total += last->capacity + sizeof(Arena);
+    }
+
+    size_t minimum = needed + sizeof(Arena) + sizeof(Block) + MIN_BUFFER_SIZE + ARENA_ALIGNMENT;
+    size_t size = 2 * (last->capacity + sizeof(Arena));
+    if (size < minimum) size = minimum;
+    if (arena->limit) {
+        if (total >= arena->limit) return NULL;
+        if (size > arena->limit - total) size = arena->limit - total;
+        if (size < minimum) return NULL;
+    }
+
+    Arena *region = arena_new_dynamic((ssize_t)size);
+    if (!region) return NULL;
+    region->use_bins = arena->use_bins;
+    region->head = arena;
+    region->is_shared = arena->is_shared;
+    last->next = region;
+    return region;
+}
+
+/*
+ * Allocate memory in every region
+ * Tries to allocate memory in the tail or from free blocks of every region, growable arenas
+ * chain a new region when none has room. Expects a rounded up size and the arena locked
+ */
+static void *alloc_in_arena(Arena *arena, size_t size) {
+    for (Arena *region = arena; region; region = region->next) {
+        void *result = alloc_in_region(region, size);
+        if (result) return result;
+    }
+
+    // binned blocks may merge into a large enough one
+    for (Arena *region = arena; region; region = region->next) {
+        if (!flush_bins(region)) continue;
+        void *result = alloc_in_region(region, size);
+        if (result) return result;
+    }
+
+    Arena *region = grow_arena(arena, size);
+    return region ? alloc_in_region(region, size) : NULL;
+}
+
+/*
+ * Allocate memory in the arena
+ * Serves small sizes from the size-class bins, larger ones from the free blocks and tail
+ * Returns NULL if there is not enough space
+ */
+void *arena_alloc(Arena *arena, size_t size) {
+    if (size == 0 || arena == NULL || size > ARENA_MAX_REQUEST) return NULL;
+    size = ARENA_ALIGN_UP(size, ARENA_ALIGNMENT); // Keeps every block header and its data aligned
+
+    lock_arena(arena);
+    void *result = alloc_in_arena(arena, size);
+    unlock_arena(arena);
+    return result;
+}
+
 /*
  * Free a block of memory in the arena
  * Marks the block as free, merges it with adjacent free blocks if possible,
@@ -473,6 +689,7 @@ void *arena_alloc(Arena *arena, size_t size) {
 static void arena_free_block_full(Arena *arena, void *data) {
     Block *block = (Block *)((void *)((char *)data - sizeof(Block)));
     block->flags.bits.is_free = true;
+    block->flags.bits.is_binned = false;
     block->left_free = NULL;
     block->right_free = NULL;
     block->flags.bits.color = RED;
@@ -518,27 +735,160 @@ static void arena_free_block_full(Arena *arena, void *data) {
 }
 
 /*
- * Free a block of memory in the arena
- * Marks the block as free, merges it with adjacent free blocks if possible,
- * and updates the free block list
+ * Validate a block
+ * Returns the region of an allocated block, NULL for invalid, corrupted or already freed pointers
  */
-void arena_free_block(void *data) {
-    if (!data) return;
-    
+static Arena *block_region(void *data) {
     Block *block = (Block *)((void *)((char *)data - sizeof(Block)));
     
-    // Magic number validation: BlockFlags has 6 bits of padding that are always 0
-    // The probability of random memory having exactly these 6 bits as 0 is very low
+    // Magic number validation: BlockFlags has 5 bits of padding that are always 0
+    // The probability of random memory having exactly these 5 bits as 0 is very low
     // This helps detect invalid/corrupted pointers
     char flags_byte = block->flags.raw;
-    if (flags_byte & ~0x3) {  // ~0x3 = 11111100 - check that padding bits are 0
-        return; 
+    if (flags_byte & ~0x7) {  // ~0x7 = 11111000 - check that padding bits are 0
+        return NULL; 
     }
+    if (block->flags.bits.is_free || block->flags.bits.is_binned) return NULL; // Already freed
 
     Arena *arena = block->arena;
-    if (!arena ||(char *)data < (char *)arena->data || (char *)data > (char *)arena->data + arena->capacity) return;
-    
-    arena_free_block_full(arena, data);
+    if (!arena ||(char *)data < (char *)arena->data || (char *)data > (char *)arena->data + arena->capacity) return NULL;
+    return arena;
+}
+
+/*
+ * Free a block in its region
+ * Small blocks go to their size-class bin, the rest is merged and returned to the free blocks.
+ * Expects the arena locked
+ */
+static void free_in_region(Arena *arena, Block *block) {
+    // Blocks in front of the tail are freed for real, so the tail can shrink back
+    if (arena->use_bins && block->size <= ARENA_BIN_MAX && next_block(arena, block) != arena->tail) {
+        push_bin(arena, block);
+        return;
+    }
+    arena_free_block_full(arena, block_data(block));
+}
+
+/*
+ * Free a block of memory in the arena
+ * Marks the block as free, merges it with adjacent free blocks if possible,
+ * and updates the free block list
+ */
+void arena_free_block(void *data) {
+    if (!data) return;
+
+    Arena *arena = block_region(data);
+    if (!arena) return;
+
+    lock_arena(arena);
+    free_in_region(arena, (Block *)((void *)((char *)data - sizeof(Block))));
+    unlock_arena(arena);
+}
+
+/*
+ * Front padding for an aligned block
+ * Bytes to skip from the block header so the data after the next header is aligned.
+ * The skipped bytes must hold a free block of their own, so the padding is 0 or at least
+ * sizeof(Block) + MIN_BUFFER_SIZE
+ */
+static inline size_t front_padding(Block *block, size_t align) {
+    size_t pad = (size_t)(-(uintptr_t)block_data(block) & (align - 1));
+    if (pad == 0) return 0;
+
+    while (pad < sizeof(Block) + MIN_BUFFER_SIZE) pad += align;
+    return pad;
+}
+
+/*
+ * Allocate aligned memory from the free blocks
+ * Looks for a block that still fits after the worst case padding, the padding stays a free block
+ */
+static void *alloc_aligned_in_free_blocks(Arena *arena, size_t size, size_t align) {
+    Block *best = bestFit(arena->free_blocks, size + align + sizeof(Block) + MIN_BUFFER_SIZE);
+    if (!best) return NULL;
+
+    detach(&arena->free_blocks, best);
+    size_t pad = front_padding(best, align);
+    if (pad) {
+        Block *block_after = next_block(arena, best);
+        Block *block = (Block *)(void *)((char *)best + pad);
+        block->size = best->size - pad;
+        block->prev = best;
+        block->arena = arena;
+        block->flags.raw = 0; // Padding bits are the magic number of arena_free_block
+        block->flags.bits.color = RED;
+        block->left_free = NULL;
+        block->right_free = NULL;
+        if (block_after) {
+            block_after->prev = block;
+        }
+
+        best->size = pad - sizeof(Block);
+        arena->free_blocks = insert(arena->free_blocks, best);
+        best = block;
+    }
+
+    best->flags.bits.is_free = false;
+    split_block(arena, best, size);
+    return block_data(best);
+}
+
+/*
+ * Allocate aligned memory from the tail of the arena
+ * The padding is allocated as a block of its own and freed right away, so it merges with a free
+ * block in front of it or stays in the free blocks
+ */
+static void *alloc_aligned_in_tail(Arena *arena, size_t size, size_t align) {
+    size_t pad = front_padding(arena->tail, align);
+    if (arena->free_size_in_tail < pad + size) return NULL;
+    if (!pad) return alloc_in_tail(arena, size);
+
+    void *gap = alloc_in_tail(arena, pad - sizeof(Block));
+    void *data = alloc_in_tail(arena, size);
+    arena_free_block_full(arena, gap);
+    return data;
+}
+
+/*
+ * Allocate aligned memory in every region
+ * Expects a rounded up size, an alignment above ARENA_ALIGNMENT and the arena locked
+ */
+static void *alloc_aligned_in_arena(Arena *arena, size_t size, size_t align) {
+    for (Arena *region = arena; region; region = region->next) {
+        void *result = alloc_aligned_in_free_blocks(region, size, align);
+        if (!result) result = alloc_aligned_in_tail(region, size, align);
+        if (result) return result;
+    }
+
+    for (Arena *region = arena; region; region = region->next) {
+        if (!flush_bins(region)) continue;
+        void *result = alloc_aligned_in_free_blocks(region, size, align);
+        if (!result) result = alloc_aligned_in_tail(region, size, align);
+        if (result) return result;
+    }
+
+    // Room for the worst case padding in front of the block
+    Arena *region = grow_arena(arena, size + align + sizeof(Block) + MIN_BUFFER_SIZE);
+    return region ? alloc_aligned_in_tail(region, size, align) : NULL;
+}
+
+/*
+ * Allocate aligned memory in the arena
+ * Like arena_alloc, with the data aligned to 'align' (a power of two). Alignments up to
+ * ARENA_ALIGNMENT are what arena_alloc returns anyway. The block is freed with arena_free_block.
+ * Returns NULL if there is not enough space or the alignment is not a power of two
+ */
+void *arena_alloc_aligned(Arena *arena, size_t size, size_t align) {
+    if (align <= ARENA_ALIGNMENT) return arena_alloc(arena, size);
+    if (align & (align - 1)) return NULL;
+    if (size == 0 || arena == NULL || size > ARENA_MAX_REQUEST) return NULL;
+    size = ARENA_ALIGN_UP(size, ARENA_ALIGNMENT);
+    if (align > SIZE_MAX - size - sizeof(Block) - MIN_BUFFER_SIZE) return NULL; // Worst case padding must not wrap
+
+    lock_arena(arena);
+    void *result = alloc_aligned_in_arena(arena, size, align);
+    unlock_arena(arena);
+    return result;
 }
 
 /*
@@ -547,14 +897,27 @@ void arena_free_block(void *data) {
  * Returns NULL if the provided size is too small, memory is NULL or size is negative
  */
 Arena *arena_new_static(void *memory, ssize_t size) {
-    if (!memory || size < 0 || (size_t)size < sizeof(Arena) + sizeof(Block) + MIN_BUFFER_SIZE) return NULL;
+    if (!memory || size < 0 || (size_t)size < sizeof(Arena) + sizeof(Block) + MIN_BUFFER_SIZE + ARENA_ALIGNMENT) return NULL;
 
+    // Blocks start on an aligned address and the capacity is a multiple of the alignment,
+    // so every split keeps the data behind each header aligned
     Arena *arena = (Arena *)memory;
-    arena->capacity = (size_t)size - sizeof(Arena);
-    arena->data = (char *)memory + sizeof(Arena);
+    char *data = (char *)ARENA_ALIGN_UP((uintptr_t)memory + sizeof(Arena), ARENA_ALIGNMENT);
+    size_t capacity = (size_t)size - (size_t)(data - (char *)memory);
+    arena->capacity = capacity & ~(size_t)(ARENA_ALIGNMENT - 1);
+    arena->data = data;
+    arena->free_blocks = NULL;
+    arena->is_growable = false;
+    arena->limit = 0;
+    arena->next = NULL;
+    arena->use_bins = true;
+    for (int i = 0; i < ARENA_BIN_COUNT; i++) arena->bins[i] = NULL;
+    arena->head = arena;
+    arena->is_shared = false;
     
     Block *block = (Block *)arena->data;
     block->size = 0;
+    block->flags.raw = 0;
     block->flags.bits.is_free = true;
     block->flags.bits.color = RED;
     block->prev = NULL;
@@ -576,7 +939,7 @@ Arena *arena_new_static(void *memory, ssize_t size) {
  * Returns NULL if the requested size is too small or size is negative
  */
 Arena *arena_new_dynamic(ssize_t size) {
-    if (size < 0 || (size_t)size < sizeof(Arena) + sizeof(Block) + MIN_BUFFER_SIZE) return NULL;
+    if (size < 0 || (size_t)size < sizeof(Arena) + sizeof(Block) + MIN_BUFFER_SIZE + ARENA_ALIGNMENT) return NULL;
     void *data = malloc((size_t)size);
     if (!data) return NULL;
     Arena *arena = arena_new_static(data, size);
@@ -586,33 +949,254 @@ Arena *arena_new_dynamic(ssize_t size) {
     return arena;
 }
 
+/*
+ * Create a growable arena
+ * A dynamic arena that chains a new region (twice the size of the last one) instead of failing
+ * when it is full. 'limit' caps the total size of all regions, 0 means no limit
+ * Returns NULL if the requested size is too small, negative or above the limit
+ */
+Arena *arena_new_growable(ssize_t size, ssize_t limit) {
+    if (limit < 0 || (limit > 0 && size > limit)) return NULL;
+    Arena *arena = arena_new_dynamic(size);
+    if (!arena) return NULL;
+
+    arena->is_growable = true;
+    arena->limit = (size_t)limit;
+
+    return arena;
+}
+
 /*
  * Reset the arena
  * Clears the arena's blocks and resets it to the initial state without freeing memory
+ * Chained regions are kept and reset as well. Thread caches are allocations of the arena too:
+ * every ArenaCache must be destroyed before the reset, neither used nor flushed after it
  */
 void arena_reset(Arena *arena) {
     if (!arena) return;
-    Block *block = (Block *)arena->data;
-    block->size = 0;
-    block->flags.bits.is_free = true;
-    block->prev = NULL;
+    lock_arena(arena);
 
-    arena->tail = block;
-    arena->free_blocks = NULL;
-    arena->free_size_in_tail = arena->capacity - sizeof(Block);
+    for (Arena *region = arena; region; region = region->next) {
+        Block *block = (Block *)region->data;
+        block->size = 0;
+        block->flags.raw = 0; // Drops is_binned of a block that waited in a bin
+        block->flags.bits.is_free = true;
+        block->flags.bits.color = RED;
+        block->prev = NULL;
+
+        region->tail = block;
+        region->free_blocks = NULL;
+        region->free_size_in_tail = region->capacity - sizeof(Block);
+        for (int i = 0; i < ARENA_BIN_COUNT; i++) region->bins[i] = NULL;
+    }
+
+    unlock_arena(arena);
 }
 
 /*
  * Free a dynamic arena
- * Releases memory for dynamically allocated arenas
+ * Releases memory for dynamically allocated arenas and every chained region
  */
 void arena_free(Arena *arena) {
-    if (!arena) return;
-    if (arena->is_dynamic) {
-        free(arena);
+    if (arena && arena->is_shared) pthread_mutex_destroy(&arena->lock);
+    while (arena) {
+        Arena *next = arena->next;
+        if (arena->is_dynamic) {
+            free(arena);
+        }
+        arena = next;
     }
 }
 
+/*
+ * Share an arena between threads
+ * From now on every allocation, free and reset takes the lock of the arena, for all its regions.
+ * Must be called before a second thread uses the arena. Returns false if the lock can not be created
+ */
+bool arena_make_shared(Arena *arena) {
+    if (!arena || arena->head != arena) return false;
+    if (arena->is_shared) return true;
+
+    if (pthread_mutex_init(&arena->lock, NULL) != 0) return false;
+    for (Arena *region = arena; region; region = region->next) region->is_shared = true;
+    return true;
+}
+
+
+/*
+ * Create a thread cache
+ * Magazines of small blocks for one thread, allocated from the arena itself
+ * An arena_reset releases the cache and its blocks, destroy it before resetting the arena
+ * Returns NULL if the arena has no room for it
+ */
+ArenaCache *arena_cache_new(Arena *arena) {
+    ArenaCache *cache = (ArenaCache *)arena_alloc(arena, sizeof(ArenaCache));
+    if (!cache) return NULL;
+
+    cache->arena = arena;
+    for (int i = 0; i < ARENA_BIN_COUNT; i++) cache->counts[i] = 0;
+    return cache;
+}
+
+/*
+ * Refill a magazine
+ * Takes half a magazine of blocks of the size class from the arena under a single lock
+ */
+static void refill_magazine(ArenaCache *cache, size_t size) {
+    size_t bin = arena_bin_index(size);
+
+    lock_arena(cache->arena);
+    while (cache->counts[bin] < ARENA_MAGAZINE_SIZE / 2) {
+        void *data = alloc_in_arena(cache->arena, size);
+        if (!data) break;
+
+        cache->magazines[bin][cache->counts[bin]++] = (Block *)((void *)((char *)data - sizeof(Block)));
+    }
+    unlock_arena(cache->arena);
+}
+
+/*
+ * Flush a magazine
+ * Returns the oldest 'count' blocks of the magazine to the arena under a single lock
+ */
+static void flush_magazine(ArenaCache *cache, size_t bin, int count) {
+    Block **magazine = cache->magazines[bin];
+
+    lock_arena(cache->arena);
+    for (int i = 0; i < count; i++) free_in_region(magazine[i]->arena, magazine[i]);
+    unlock_arena(cache->arena);
+
+    cache->counts[bin] -= count;
+    for (int i = 0; i < cache->counts[bin]; i++) magazine[i] = magazine[i + count];
+}
+
+/*
+ * Allocate memory through a thread cache
+ * Small sizes pop a block of the thread's magazine without locking, larger ones use arena_alloc
+ * Returns NULL if there is not enough space
+ */
+void *arena_cache_alloc(ArenaCache *cache, size_t size) {
+    if (!cache || size == 0) return NULL;
+    if (size > ARENA_BIN_MAX) return arena_alloc(cache->arena, size);
+    size = ARENA_ALIGN_UP(size, ARENA_ALIGNMENT);
+
+    size_t bin = arena_bin_index(size);
+    if (cache->counts[bin] == 0) refill_magazine(cache, size);
+    if (cache->counts[bin] == 0) return NULL;
+
+    return block_data(cache->magazines[bin][--cache->counts[bin]]);
+}
+
+/*
+ * Free memory through a thread cache
+ * Small blocks of the cache's arena go to the thread's magazine, a full magazine returns half of
+ * its blocks at once. Everything else is freed with arena_free_block
+ */
+void arena_cache_free(ArenaCache *cache, void *data) {
+    if (!cache || !data) return;
+
+    Arena *region = block_region(data);
+    if (!region) return;
+
+    Block *block = (Block *)((void *)((char *)data - sizeof(Block)));
+    if (block->size > ARENA_BIN_MAX || region->head != cache->arena) {
+        arena_free_block(data);
+        return;
+    }
+
+    size_t bin = arena_bin_index(block->size);
+    if (cache->counts[bin] == ARENA_MAGAZINE_SIZE) flush_magazine(cache, bin, ARENA_MAGAZINE_SIZE / 2);
+
+    cache->magazines[bin][cache->counts[bin]++] = block;
+}
+
+/*
+ * Flush a thread cache
+ * Returns every cached block to the arena
+ */
+void arena_cache_flush(ArenaCache *cache) {
+    if (!cache) return;
+    for (size_t bin = 0; bin < ARENA_BIN_COUNT; bin++) {
+        if (cache->counts[bin]) flush_magazine(cache, bin, cache->counts[bin]);
+    }
+}
+
+/*
+ * Destroy a thread cache
+ * Flushes the cache and frees it
+ */
+void arena_cache_destroy(ArenaCache *cache) {
+    if (!cache) return;
+    arena_cache_flush(cache);
+    arena_free_block(cache);
+}
+
+/*
+ * Create a scratch arena
+ * Allocates a bump-only region of 'capacity' bytes (and the Scratch itself) from the arena
+ * Returns NULL if the arena has no room for it
+ */
+Scratch *scratch_new(Arena *arena, size_t capacity) {
+    Scratch *scratch = (Scratch *)arena_alloc(arena, sizeof(Scratch));
+    if (!scratch) return NULL;
+
+    capacity = ARENA_ALIGN_UP(capacity, ARENA_ALIGNMENT);
+    scratch->data = (char *)arena_alloc(arena, capacity);
+    if (!scratch->data) {
+        arena_free_block(scratch);
+        return NULL;
+    }
+    scratch->capacity = capacity;
+    scratch->used = 0;
+    scratch->high_water = 0;
+    scratch->arena = arena;
+
+    return scratch;
+}
+
+/*
+ * Allocate memory in the scratch arena
+ * Bumps the offset, no header and no free. The memory is valid until the next scratch_reset
+ * Returns NULL if the region is full, the high water mark still records the request
+ */
+void *scratch_alloc(Scratch *scratch, size_t size) {
+    if (!scratch || size == 0) return NULL;
+
+    // Checked before rounding, so neither the size nor the offset can wrap
+    if (size > scratch->capacity - scratch->used) {
+        size_t wanted = (size > SIZE_MAX - scratch->used) ? SIZE_MAX : scratch->used + size;
+        if (wanted > scratch->high_water) scratch->high_water = wanted;
+        return NULL;
+    }
+    size = ARENA_ALIGN_UP(size, ARENA_ALIGNMENT);
+    if (size > scratch->capacity - scratch->used) return NULL;
+
+    size_t used = scratch->used + size;
+    if (used > scratch->high_water) scratch->high_water = used;
+
+    void *result = scratch->data + scratch->used;
+    scratch->used = used;
+    return result;
+}
+
+/*
+ * Reset the scratch arena
+ * Releases every scratch allocation in O(1)
+ */
+void scratch_reset(Scratch *scratch) {
+    if (scratch) scratch->used = 0;
+}
+
+/*
+ * Free a scratch arena
+ * Returns the region to the arena it was allocated from
+ */
+void scratch_free(Scratch *scratch) {
+    if (!scratch) return;
+    arena_free_block(scratch->data);
+    arena_free_block(scratch);
+}
+
 #ifdef DEBUG
 /*
  * Helper function to print LLRB tree structure
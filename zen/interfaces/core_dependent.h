@@ -17,6 +17,7 @@ typedef struct CoreDependent {
     void (*shutdown)     (Zen *zen);
 
     Screen *(*get_screen)(Zen *zen);
+    void *(*scratch_alloc)(Zen *zen, size_t size);
 } CoreDependent;
 
 // CoreDependent macros
@@ -42,6 +43,13 @@ static inline Screen *CORE_GET_SCREEN(const void *object) {
     return NULL;
 }
 
+static inline void *CORE_SCRATCH_ALLOC(const void *object, size_t size) {
+    if (IS_CORE_DEPENDENT(object)) {
+        return CORE_DEPENDENT_HANDLER(object)->scratch_alloc(GET_CORE(object), size);
+    }
+    return NULL;
+}
+
 static inline void CORE_CHANGE_LAYER(const void *object, int layer) {
     if (IS_CORE_DEPENDENT(object)) {
         CORE_DEPENDENT_HANDLER(object)->change_layer(GET_CORE(object), layer);
@@ -27,6 +27,8 @@ typedef struct Coords Coords;
 
 typedef struct Container Container;
 
+typedef struct Canvas Canvas;
+
 typedef struct TimeManager TimeManager;
 typedef struct TickCounter TickCounter;
 typedef struct FrameTimer FrameTimer;
@@ -12,6 +12,7 @@ Zen *zen_init(Arena *arena) {
     Zen *zen = (Zen *)arena_alloc(arena, sizeof(Zen));
     
     zen->arena        = arena;
+    zen->scratch      = scratch_new(arena, ZEN_SCRATCH_SIZE);
     zen->input_type   = INPUT_TYPE_CURSOR;
     zen->time_manager = init_time_manager();
     zen->frame_timer  = init_frame_timer();
@@ -20,6 +21,123 @@ Zen *zen_init(Arena *arena) {
     return zen;
 }
 
+/*
+ * Draw objects of a layer
+ * Draws every active drawable object of the layer onto the given screen
+ */
+static void draw_layer_objects(Zen *zen, MapLayer *layer, Screen *screen) {
+    for (int y = 0; y < layer->height; y++) {
+        for (int x = 0; x < layer->width; x++) {
+            void *target_struct = layer->objects[y][x].object;
+            if (!target_struct) continue;
+
+            if (IS_ACTIVE_DRAWABLE(target_struct)) {
+                DRAW(target_struct, screen, zen->cursor);
+            }
+        }
+    }
+}
+
+/*
+ * Render static cells of a layer
+ * Runs prepare_screen on the cached cells of the layer, a frozen base layer also draws its objects
+ */
+static void render_static_cells(Zen *zen, MapLayer *layer, bool with_objects) {
+    Screen *cells = layer->static_cells;
+    if (!cells) {
+        cells = layer->static_cells = screen_create_layer(zen->screen);
+    }
+    else {
+        screen_resize(cells, zen->screen->width, zen->screen->height);
+        screen_clear_layer(cells);
+    }
+
+    if (layer->prepare_screen) {
+        layer->prepare_screen(cells);
+    }
+    if (with_objects) draw_layer_objects(zen, layer, cells);
+}
+
+/*
+ * Prepare screen for the current layer
+ * Plain layers prepare the screen directly. Composited layers render their static cells and
+ * freeze the layers below once, every frame then only composites them and redraws the objects.
+ */
+static void prepare_current_layer(Zen *zen) {
+    MapLayer *layer = map_get_current_layer(zen->map);
+    if (layer->base_layer < 0) {
+        if (layer->prepare_screen) {
+            layer->prepare_screen(zen->screen);
+        }
+        return;
+    }
+
+    render_static_cells(zen, layer, false);
+    MapLayer *base = map_get_base_layer(zen->map, layer);
+    for (int depth = 0; base && depth < zen->map->layers_count; depth++) { // Bounded in case of a base cycle
+        render_static_cells(zen, base, true);
+        base = map_get_base_layer(zen->map, base);
+    }
+}
+
+/*
+ * Share damage of the layer stack
+ * Cells are composited bottom first, so every cached layer of the stack recomposites the same cells:
+ * each row gets the union of the dirty spans of all layers
+ */
+static void share_layer_damage(Zen *zen, MapLayer *layer) {
+    for (int y = 0; y < zen->screen->height; y++) {
+        int first = zen->screen->width;
+        int last = -1;
+        MapLayer *cached = layer;
+        for (int depth = 0; cached && depth <= zen->map->layers_count; depth++) { // Bounded like composite_layers
+            int start, end;
+            if (cached->static_cells && screen_get_dirty_span(cached->static_cells, y, &start, &end)) {
+                if (start < first) first = start;
+                if (end > last) last = end;
+            }
+            cached = map_get_base_layer(zen->map, cached);
+        }
+        if (last < 0) continue;
+
+        cached = layer;
+        for (int depth = 0; cached && depth <= zen->map->layers_count; depth++) {
+            screen_mark_dirty(cached->static_cells, y, first, 1, last - first + 1);
+            cached = map_get_base_layer(zen->map, cached);
+        }
+    }
+}
+
+/*
+ * Composite static layers
+ * Composites the frozen base layers bottom first, then the static cells of the layer itself.
+ * Only damaged cells are composited, the damage is cleared afterwards
+ */
+static void composite_layers(Zen *zen, MapLayer *layer, int depth) {
+    MapLayer *base = map_get_base_layer(zen->map, layer);
+    if (base && depth < zen->map->layers_count) { // Bounded in case of a base cycle
+        composite_layers(zen, base, depth + 1);
+    }
+    if (layer->static_cells) {
+        screen_composite(zen->screen, layer->static_cells);
+        screen_clear_dirty(layer->static_cells);
+    }
+}
+
+/*
+ * Keep overlay damage
+ * Objects, cursor and stats are drawn over the composited cells every frame. The cells they touched
+ * are marked on the static cells of the layer, so the next frame composites them again and erases
+ * whatever moved
+ */
+static void keep_overlay_damage(Screen *screen, Screen *cells) {
+    if (!cells) return;
+    for (int y = 0; y < screen->height; y++) {
+        int start, end;
+        if (screen_get_dirty_span(screen, y, &start, &end)) screen_mark_dirty(cells, y, start, 1, end - start + 1);
+    }
+}
+
 /*
  * Set new map to core engine
  * Assigns new map and validates all interfaces
@@ -35,6 +153,7 @@ void zen_set_map(Zen *zen, Map *map) {
         .global_move = zen_global_move,
         .local_move = zen_local_move,
         .get_screen = zen_get_screen,
+        .scratch_alloc = zen_scratch_alloc,
         .shutdown = zen_shutdown
     };
 
@@ -83,10 +202,7 @@ void zen_set_map(Zen *zen, Map *map) {
 
     }
 
-    MapLayer *layer = map_get_current_layer(zen->map);
-    if (layer->prepare_screen) {
-        layer->prepare_screen(zen->screen);
-    }
+    prepare_current_layer(zen);
 }
 
 /*
@@ -194,23 +310,24 @@ void zen_action(Zen *zen) {
  * Draws all visible objects and cursor
  */
 void zen_update_screen(Zen *zen) {
-    // Draw all objects on map
+    scratch_reset(zen->scratch);
+
+    // Composite cached layers, then draw all objects of the current layer
     MapLayer *layer = map_get_current_layer(zen->map);
-    for (int y = 0; y < layer->height; y++) {
-        for (int x = 0; x < layer->width; x++) {
-            void *target_struct = layer->objects[y][x].object;
-            if (!target_struct) continue;
-            
-            if (IS_ACTIVE_DRAWABLE(target_struct)) {
-                DRAW(target_struct, zen->screen, zen->cursor);
-            }
-        }
+    if (layer->base_layer >= 0) {
+        share_layer_damage(zen, layer);
+        composite_layers(zen, layer, 0);
     }
+    draw_layer_objects(zen, layer, zen->screen);
 
     // Draw cursor and update screen
     print_cursor(zen->cursor, zen->screen);
     draw_fps_stats(zen->frame_timer.stats, zen->screen);
+    if (layer->base_layer >= 0) keep_overlay_damage(zen->screen, layer->static_cells);
     print_screen(zen->screen);
+
+    const ScreenStats *output = &zen->screen->stats;
+    update_frame_pacing(&zen->frame_timer, (double)output->last_write_ns / 1e9, output->last_frame_bytes, output->queued_bytes);
 }
 
 /*
@@ -292,10 +409,7 @@ void zen_change_layer(Zen *zen, int layer) {
     }
     zen->cursor->subject = object.object;
 
-    MapLayer *layer_ = map_get_current_layer(zen->map);
-    if (layer_->prepare_screen) {
-        layer_->prepare_screen(zen->screen);
-    }
+    prepare_current_layer(zen);
 }
 
 /*
@@ -344,8 +458,14 @@ void zen_set_target_fps(Zen *zen, int fps) {
 bool zen_should_close(Zen *zen) {
     update_time_manager(&zen->time_manager);
 
+    // Follow terminal resizes, the layer prepares the new screen and the next frame repaints it fully
+    if (screen_poll_resize(zen->screen)) {
+        prepare_current_layer(zen);
+    }
+
     // Update game logic if it's time for a new tick
     if (should_update_ticks(&zen->tick_counter, &zen->time_manager)) {
+        scratch_reset(zen->scratch);
         zen_update(zen);
     }
 
@@ -395,6 +515,15 @@ void zen_show_fps(Zen *zen, bool state) {
     if (zen->frame_timer.stats) zen->frame_timer.stats->draw_to_screen = state;
 }
 
+/*
+ * Toggle adaptive FPS
+ * Lowers the frame rate (or skips frames) while the terminal cannot keep up with the output,
+ * recovering to the target FPS once it drains. Decisions are visible in the FPS statistics.
+ */
+void zen_set_adaptive_fps(Zen *zen, bool state) {
+    set_adaptive_pacing(&zen->frame_timer, state);
+}
+
 /*
  * Set ticks per second
  * Configures the number of logic updates per second.
@@ -402,3 +531,50 @@ void zen_show_fps(Zen *zen, bool state) {
 void zen_set_ticks_per_second(Zen *zen, int ticks_per_second) {
     set_ticks_per_second(&zen->tick_counter, ticks_per_second);
 }
+
+/*
+ * Toggle render thread
+ * Moves frame encoding and terminal output to a dedicated thread, so slow output does not delay ticks.
+ * Returns true if the requested state is active.
+ */
+bool zen_set_render_thread(Zen *zen, bool state) {
+    if (!state) {
+        screen_stop_render_thread(zen->screen);
+        return true;
+    }
+    return screen_start_render_thread(zen->screen);
+}
+
+/*
+ * Allocate scratch memory
+ * Bump allocation that lives until the next tick or frame, never freed by the caller.
+ * Returns NULL if the scratch arena is full, see zen_scratch_high_water.
+ */
+void *zen_scratch_alloc(Zen *zen, size_t size) {
+    return scratch_alloc(zen->scratch, size);
+}
+
+/*
+ * Get scratch high water mark
+ * Returns the most scratch memory a single tick or frame asked for so far.
+ */
+size_t zen_scratch_high_water(Zen *zen) {
+    return zen->scratch ? zen->scratch->high_water : 0;
+}
+
+/*
+ * Set scratch size
+ * Replaces the scratch arena with one of the given size, the high water mark is kept.
+ * Returns false if the arena has no room for it, the old scratch arena stays in use.
+ */
+bool zen_set_scratch_size(Zen *zen, size_t size) {
+    Scratch *scratch = scratch_new(zen->arena, size);
+    if (!scratch) return false;
+
+    if (zen->scratch) {
+        scratch->high_water = zen->scratch->high_water;
+        scratch_free(zen->scratch);
+    }
+    zen->scratch = scratch;
+    return true;
+}
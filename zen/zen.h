@@ -4,6 +4,7 @@
 #define _POSIX_C_SOURCE 199309L
 
 #include <fcntl.h>
+#include <errno.h>
 #include <sys/select.h>
 #include <stdbool.h>
 #include <wchar.h>
@@ -30,6 +31,9 @@
 #define KEY_CTRL_A 1
 #define KEY_CTRL_D 4
 
+// Default size of the per-frame scratch arena
+#define ZEN_SCRATCH_SIZE (16 * 1024)
+
 
 typedef enum {
     INPUT_TYPE_CURSOR,
@@ -44,6 +48,7 @@ typedef struct Zen {
     Cursor      *cursor;     // cursor
     Screen      *screen;     // screen
     Arena       *arena;      // arena allocator
+    Scratch     *scratch;    // per-frame scratch arena, reset every tick and frame
     Map         *map;        // map
     InputType   input_type;
     TimeManager time_manager;
@@ -75,7 +80,12 @@ bool zen_has_input(void);
 void zen_enable_fps_stats(Zen *zen);
 void zen_disable_fps_stats(Zen *zen);
 void zen_show_fps(Zen *zen, bool state);
+void zen_set_adaptive_fps(Zen *zen, bool state);
 void zen_set_ticks_per_second(Zen *zen, int ticks_per_second);
+bool zen_set_render_thread(Zen *zen, bool state);
+void *zen_scratch_alloc(Zen *zen, size_t size);
+size_t zen_scratch_high_water(Zen *zen);
+bool zen_set_scratch_size(Zen *zen, size_t size);
 
 Screen *zen_get_screen(Zen *zen);
 